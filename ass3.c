@@ -10,47 +10,20 @@
 //------------------------------------------------------------------------------
 //
 
+// fopencookie, see _OutputArena_
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#include "qrc_ecc.h"
-
-const uint8_t MAX_INPUT_STRING_SIZE = 106;
-const uint8_t NUMBER_OF_QR_FLAVORS = 11;
-const uint8_t NIBBLE_SIZE = 4;
-const uint8_t MODULE_VALUE_BIT = 0;
-const uint8_t MODULE_TAKEN_BIT = 1;
-const uint8_t MODULE_DATA_FLAG_BIT = 2;
-const uint8_t SYNC_PATTERN_POS = 6;
-const uint8_t FORMAT_VERSION_POS = 8;
-const uint8_t FORMAT_VERSION_LENGTH = 15;
-const uint8_t MASK_PATTERN_ID = 6;
-
-
-#define POS_PATTERN_SIZE 7
-const uint8_t POS_PATTERN[POS_PATTERN_SIZE][POS_PATTERN_SIZE] =
-{
-  {3, 3, 3, 3, 3, 3, 3},
-  {3, 2, 2, 2, 2, 2, 3},
-  {3, 2, 3, 3, 3, 2, 3},
-  {3, 2, 3, 3, 3, 2, 3},
-  {3, 2, 3, 3, 3, 2, 3},
-  {3, 2, 2, 2, 2, 2, 3},
-  {3, 3, 3, 3, 3, 3, 3}
-};
-
-#define ALIGNMENT_PATTERN_SIZE 5
-const uint8_t ALIGNMENT_PATTERN[ALIGNMENT_PATTERN_SIZE][ALIGNMENT_PATTERN_SIZE] 
-=
-{
-  {3, 3, 3, 3, 3},
-  {3, 2, 2, 2, 3},
-  {3, 2, 3, 2, 3},
-  {3, 2, 2, 2, 3},
-  {3, 3, 3, 3, 3}
-};
+#include "qrc_encode.h"
 
 enum 
 {
@@ -62,184 +35,277 @@ enum
   ERR_IO = 5
 };
 
-enum {
-  UP = -1,
-  DOWN = 1
-};
-
-enum {
-  LEFT = -1,
-  RIGHT = 1
-};
-
-const uint8_t QR_MODE = 0x04;
-
-
-
-struct _MessageData_ 
-{
-  uint8_t mode_;
-  uint8_t data_len_;
-  unsigned char *data_;
-};
+//------------------------------------------------------------------------------
+///
+/// Size of the buffer a text frame is built in, the text of the largest 
+/// matrix has 2 characters per module including the newlines. A half-block 
+/// frame takes less, see writeMatrixAsHalfBlocks.
+//
+#define TEXT_BUFFER_SIZE (2 * QR_MAX_MATRIX_SIZE * QR_MAX_MATRIX_SIZE)
 
-struct _QRFlavor_ 
-{
-  uint8_t capacity_;
-  uint8_t version_;
-  unsigned char ec_level_;
-  uint8_t ec_data_;
-  uint8_t alignment_pattern_pos_;
-}; 
-
-const struct _QRFlavor_ QRFlavors[] = 
-{
-  {.capacity_ =   7, .version_ = 1, .ec_level_ = 'H', .ec_data_ = 17, 
-    .alignment_pattern_pos_ = 0},
-  {.capacity_ =  11, .version_ = 1, .ec_level_ = 'Q', .ec_data_ = 13, 
-    .alignment_pattern_pos_ = 0},
-  {.capacity_ =  14, .version_ = 1, .ec_level_ = 'M', .ec_data_ = 10, 
-    .alignment_pattern_pos_ = 0},
-  {.capacity_ =  17, .version_ = 1, .ec_level_ = 'L', .ec_data_ =  7, 
-    .alignment_pattern_pos_ = 0},
-  {.capacity_ =  20, .version_ = 2, .ec_level_ = 'Q', .ec_data_ = 22, 
-    .alignment_pattern_pos_ = 18},
-  {.capacity_ =  26, .version_ = 2, .ec_level_ = 'M', .ec_data_ = 16, 
-    .alignment_pattern_pos_ = 18},
-  {.capacity_ =  32, .version_ = 2, .ec_level_ = 'L', .ec_data_ = 10, 
-    .alignment_pattern_pos_ = 18},
-  {.capacity_ =  42, .version_ = 3, .ec_level_ = 'M', .ec_data_ = 26, 
-    .alignment_pattern_pos_ = 22},
-  {.capacity_ =  53, .version_ = 3, .ec_level_ = 'L', .ec_data_ = 15, 
-    .alignment_pattern_pos_ = 22},
-  {.capacity_ =  78, .version_ = 4, .ec_level_ = 'L', .ec_data_ = 20, 
-    .alignment_pattern_pos_ = 26},
-  {.capacity_ = 106, .version_ = 5, .ec_level_ = 'L', .ec_data_ = 26, 
-    .alignment_pattern_pos_ = 30},
-};
+//------------------------------------------------------------------------------
+///
+/// UTF-8 encoded half-blocks of writeMatrixAsHalfBlocks, indexed by the 
+/// module of the upper row plus 2 times the one of the lower row
+//
+static const char *const HALF_BLOCKS[4] = 
+  {" ", "\xE2\x96\x80", "\xE2\x96\x84", "\xE2\x96\x88"};
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Set the module taken flag for \p module
+/// @brief Writes the \p matrix as text to \p fp. The frame is built in a 
+/// buffer and written at once.
 /// 
-/// @param module The module for which to set the flag
-/// @param taken The taken flag
+/// @param fp The stream to write to
+/// @param matrix The matrix to display
+///
+/// @return 0 on success, EOF if writing failed
 //
-void setModuleTaken(uint8_t *module, uint8_t taken) 
+int writeMatrixAsText(FILE *fp, const struct _QRMatrix_ *matrix)
 {
-  if (taken) *module |= (1 << MODULE_TAKEN_BIT);
-  else *module &= (1 << MODULE_TAKEN_BIT);
+  const uint8_t size = matrix->size_;
+  char buffer[TEXT_BUFFER_SIZE];
+  char *position = buffer;
+
+  for (uint8_t row = 0; row < size; row++)
+  {
+    for (uint8_t column = 0; column < size; column++)
+    {
+      *(position++) = (getMatrixModule(matrix, row, column) == 1) ? '#' : ' ';
+      *(position++) = column < size - 1 ? ' ' : '\n';
+    }
+  }
+
+  const size_t frame_size = position - buffer;
+  return fwrite(buffer, 1, frame_size, fp) == frame_size ? 0 : EOF;
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Returns if the \p module is already in use
+/// @brief Writes the \p matrix as text to \p fp, every line shows two module
+/// rows with the half-blocks of HALF_BLOCKS. The frame is built in a buffer 
+/// and written at once.
 /// 
-/// @param module The module for which to set the flag
+/// @param fp The stream to write to
+/// @param matrix The matrix to display
 ///
-/// @return uint8_t True if taken, else false
+/// @return 0 on success, EOF if writing failed
 //
-uint8_t isModuleTaken(uint8_t module) 
+int writeMatrixAsHalfBlocks(FILE *fp, const struct _QRMatrix_ *matrix)
 {
-  return (module >> MODULE_TAKEN_BIT) & 1;
+  const uint8_t size = matrix->size_;
+  char buffer[TEXT_BUFFER_SIZE];
+  char *position = buffer;
+
+  for (uint8_t row = 0; row < size; row += 2)
+  {
+    for (uint8_t column = 0; column < size; column++)
+    {
+      // the row below the last one of an odd size is light
+      const uint8_t modules = getMatrixModule(matrix, row, column) + 
+        (row + 1 < size ? 2 * getMatrixModule(matrix, row + 1, column) : 0);
+      const size_t length = strlen(HALF_BLOCKS[modules]);
+
+      memcpy(position, HALF_BLOCKS[modules], length);
+      position += length;
+    }
+    *(position++) = '\n';
+  }
+
+  const size_t frame_size = position - buffer;
+  return fwrite(buffer, 1, frame_size, fp) == frame_size ? 0 : EOF;
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Set the \p module value
+/// @brief Writes the \p matrix to stdout
 /// 
-/// @param module The module for which to set the value
-/// @param value 1 or zero (in fact, everything other than zero is treated as 1)
+/// @param matrix The matrix to display
+/// @param half_blocks Whether two module rows are shown per line, see 
+/// writeMatrixAsHalfBlocks
 //
-void setModuleValue(uint8_t *module, uint8_t value)
+void outputMatrix(const struct _QRMatrix_ *matrix, bool half_blocks)
 {
-  if (value) *module |= (1 << MODULE_VALUE_BIT);
-  else *module &= (0 << MODULE_VALUE_BIT);
-  setModuleTaken(module, 1);
+  if (half_blocks) writeMatrixAsHalfBlocks(stdout, matrix);
+  else writeMatrixAsText(stdout, matrix);
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Get the \p module value
+/// @brief Outputs the IO error text and exits with corresponding error code
 /// 
-/// @param module The module for which to get the value
-///
-/// @return uint8_t 1 or 0
+/// @param filename Name of the file which caused the error
 //
-uint8_t getModuleValue(uint8_t module)
+static inline void exitWithIOError(const char filename[])
 {
-  return module & 1;
+  printf("[ERR] Could not write file %s.\n", filename);
+  exit(ERR_IO);
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Set the \p module Data Flag
-/// The data flag specifies wether a module is used for the payload data or not
+/// Layout of the SVG documents: the modules are user units scaled to 
+/// SVG_MODULE_SIZE pixels, the symbol is surrounded by a light border of 
+/// SVG_QUIET_ZONE modules.
+//
+#define SVG_MODULE_SIZE 10
+#define SVG_QUIET_ZONE 4
+
+//------------------------------------------------------------------------------
+///
+/// Size of the buffer an SVG document is formatted into before it is written.
+/// The path of a large symbol takes about 100 kB, so it is written at once;
+/// the buffer is flushed when less than SVG_MAX_RUN_LENGTH bytes, the longest
+/// path command of a run "m177 0h177v1h-177z", are left.
+//
+#define SVG_BUFFER_SIZE (1 << 17)
+#define SVG_MAX_RUN_LENGTH 18
+
+//------------------------------------------------------------------------------
+///
+/// @brief Copies \p text without its terminator to \p position
 /// 
-/// @param module The module for which to set the flag
-/// @param value The data flag
+/// @param position The position to write to
+/// @param text The text to copy
+///
+/// @return The position after the copied text
 //
-void setModuleDataFlag(uint8_t *module, uint8_t value)
+static inline char *appendText(char *position, const char *text)
 {
-  if (value) *module |= (1 << MODULE_DATA_FLAG_BIT);
-  else *module &= (0 << MODULE_DATA_FLAG_BIT);
+  const size_t length = strlen(text);
+
+  memcpy(position, text, length);
+  return position + length;
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Returns wether a \p module is used for payload data
+/// @brief Formats \p number as decimal number to \p position
 /// 
-/// @param module The module to check
-/// @return uint8_t True if module is used for payload, else false
+/// @param position The position to write to
+/// @param number The number to format
+///
+/// @return The position after the number
 //
-uint8_t getModuleDataFlag(uint8_t module)
+static inline char *appendNumber(char *position, unsigned number)
 {
-  return (module >> MODULE_DATA_FLAG_BIT) & 1;
+  char digits[10];
+  uint8_t count = 0;
+
+  do
+  {
+    digits[count++] = '0' + number % 10;
+    number /= 10;
+  } while (number > 0);
+
+  while (count > 0) *(position++) = digits[--count];
+  return position;
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Shortcut to set value and data flag at once
+/// @brief Writes the formatted part of an SVG document to \p fp
 /// 
-/// @param module The module to use
-/// @param value The module value that should be set
+/// @param fp The stream to write to
+/// @param buffer The buffer the document is formatted into
+/// @param position The position after the formatted part
+///
+/// @return 0 on success, EOF if writing failed
 //
-void setModuleDataValue(uint8_t *module, uint8_t value)
+static inline int flushSVGBuffer(FILE *fp, const char *buffer, 
+const char *position)
 {
-  setModuleValue(module, value);
-  setModuleDataFlag(module, true);
+  const size_t size = position - buffer;
+
+  return fwrite(buffer, 1, size, fp) == size ? 0 : EOF;
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Writes the \p matrix to stdout
+/// @brief Writes the matrix as SVG document to \p fp. The dark modules are 
+/// drawn as a single path, every horizontal run of dark modules is one 
+/// rectangle of the path.
 /// 
-/// @param matrix The matrix to display
-/// @param size The matrix size
+/// @param fp The stream to write to
+/// @param matrix The matrix to use
+///
+/// @return 0 on success, EOF if writing failed
 //
-void outputMatrix(uint8_t **matrix, uint8_t size)
+int writeMatrixAsSVG(FILE *fp, const struct _QRMatrix_ *matrix)
 {
+  const uint8_t size = matrix->size_;
+  const unsigned extent = size + 2 * SVG_QUIET_ZONE;
+  char buffer[SVG_BUFFER_SIZE];
+  char *position = buffer;
+
+  position = appendText(position, "<?xml version=\"1.0\"?>\n"
+    "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.0//EN\" "
+    "\"http://www.w3.org/TR/2001/REC-SVG-20010904/DTD/svg10.dtd\">\n"
+    "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+  position = appendNumber(position, extent * SVG_MODULE_SIZE);
+  position = appendText(position, "\" height=\"");
+  position = appendNumber(position, extent * SVG_MODULE_SIZE);
+  position = appendText(position, "\" viewBox=\"0 0 ");
+  position = appendNumber(position, extent);
+  position = appendText(position, " ");
+  position = appendNumber(position, extent);
+  position = appendText(position, "\" shape-rendering=\"crispEdges\">\n"
+    "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n"
+    "<path fill=\"black\" d=\"");
+
   for (uint8_t row = 0; row < size; row++)
   {
-    for (uint8_t column = 0; column < size; column++)
+    int16_t previous_start = -1;
+    uint8_t col = 0;
+
+    while (col < size)
     {
-      printf("%c", (getModuleValue(matrix[row][column]) == 1) ? '#' : ' ');
-      if (column < size - 1) printf("%s", " ");
+      if (getMatrixModule(matrix, row, col) != 1)
+      {
+        col++;
+        continue;
+      }
+
+      const uint8_t start = col;
+      while (col < size && getMatrixModule(matrix, row, col) == 1) col++;
+
+      if (buffer + SVG_BUFFER_SIZE - position < SVG_MAX_RUN_LENGTH)
+      {
+        if (flushSVGBuffer(fp, buffer, position) == EOF) return EOF;
+        position = buffer;
+      }
+
+      // a closed rectangle ends at its start, the next one of the row is 
+      // moved to relative to it
+      if (previous_start < 0)
+      {
+        *(position++) = 'M';
+        position = appendNumber(position, start + SVG_QUIET_ZONE);
+        *(position++) = ' ';
+        position = appendNumber(position, row + SVG_QUIET_ZONE);
+      }
+      else
+      {
+        *(position++) = 'm';
+        position = appendNumber(position, start - previous_start);
+        position = appendText(position, " 0");
+      }
+      *(position++) = 'h';
+      position = appendNumber(position, col - start);
+      position = appendText(position, "v1h-");
+      position = appendNumber(position, col - start);
+      *(position++) = 'z';
+      previous_start = start;
     }
-    printf("%s", "\n");
   }
-}
 
-//------------------------------------------------------------------------------
-///
-/// @brief Outputs the IO error text and exits with corresponding error code
-/// 
-/// @param filename Name of the file which caused the error
-//
-static inline void exitWithIOError(char filename[])
-{
-  printf("[ERR] Could not write file %s.\n", filename);
-  exit(ERR_IO);
+  if (buffer + SVG_BUFFER_SIZE - position < SVG_MAX_RUN_LENGTH)
+  {
+    if (flushSVGBuffer(fp, buffer, position) == EOF) return EOF;
+    position = buffer;
+  }
+  position = appendText(position, "\"/>\n</svg>");
+  return flushSVGBuffer(fp, buffer, position);
 }
 
 //------------------------------------------------------------------------------
@@ -247,46 +313,45 @@ static inline void exitWithIOError(char filename[])
 /// @brief Writes the matrix as SVG file
 /// 
 /// @param matrix The matrix to use
-/// @param size The matrix size
 /// @param filename The filename under which the svg should be saved
 //
-void outputMatrixToSVGFile(uint8_t **matrix, uint8_t size, char filename[])
+void outputMatrixToSVGFile(const struct _QRMatrix_ *matrix, 
+const char filename[])
 {
-  const uint8_t module_size = 10;
   FILE *fp;
-  int return_value;
 
   fp = fopen(filename, "w");
   if (!fp) exitWithIOError(filename);
 
-  return_value = fputs("<?xml version=\"1.0\"?>\n"
-        "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.0//EN\" "
-        "\"http://www.w3.org/TR/2001/REC-SVG-20010904/DTD/svg10.dtd\">\n"
-        "<svg xmlns=\"http://www.w3.org/2000/svg\">",
-        fp);
-  if (return_value == EOF) exitWithIOError(filename);
+  if (writeMatrixAsSVG(fp, matrix) == EOF) exitWithIOError(filename);
+  if (fclose(fp) == EOF) exitWithIOError(filename); 
+}
 
-  // border width 4x module size
-  return_value = fprintf(fp, "<rect x=\"0\" y=\"0\" width=\"%i\" height=\"%i\" "
-    "style=\"fill:%s\"/>\n",
-    module_size * (8 + size), module_size * (8 + size), "white");
-  if (return_value < 0) exitWithIOError(filename);
+//------------------------------------------------------------------------------
+///
+/// @brief Writes the matrix as CSV to \p fp
+/// 
+/// @param fp The stream to write to
+/// @param matrix The matrix to use
+///
+/// @return 0 on success, EOF if writing failed
+//
+int writeMatrixAsCSV(FILE *fp, const struct _QRMatrix_ *matrix)
+{
+  const uint8_t size = matrix->size_;
+  int return_value;
 
   for (uint8_t row = 0; row < size; row++)
   {
     for (uint8_t col = 0; col < size; col++)
     {
-      return_value = fprintf(fp, "<rect x=\"%i\" y=\"%i\" width=\"%i\" height=\"%i\" "
-        "style=\"fill:%s\"/>\n",
-        (col + 4) * module_size, (row + 4) * module_size, module_size,
-        module_size, (getModuleValue(matrix[row][col]) == 1) ? "black" : 
-          "white");
-      if (return_value < 0) exitWithIOError(filename);
+      return_value = fprintf(fp, "%i;", getMatrixModule(matrix, row, col));
+      if (return_value < 0) return EOF;
     }
+    return_value = fprintf(fp, "%s", "\n");
+    if (return_value < 0) return EOF;
   }
-
-  fputs("</svg>", fp);
-  if (fclose(fp) == EOF) exitWithIOError(filename); 
+  return 0;
 }
 
 //------------------------------------------------------------------------------
@@ -294,586 +359,2003 @@ void outputMatrixToSVGFile(uint8_t **matrix, uint8_t size, char filename[])
 /// @brief Writes the matrix as CSV file
 /// 
 /// @param matrix The matrix to use
-/// @param size The matrix size
 /// @param filename The filename under which the csv should be saved
 //
-void outputMatrixToCSVFile(uint8_t **matrix, uint8_t size, char filename[])
+void outputMatrixToCSVFile(const struct _QRMatrix_ *matrix, 
+const char filename[])
 {
   FILE *fp;
-  int return_value;
 
   fp = fopen(filename, "w");
   if (!fp) exitWithIOError(filename);
 
-  for (uint8_t row = 0; row < size; row++)
-  {
-    for (uint8_t col = 0; col < size; col++)
-    {
-      return_value = fprintf(fp, "%i;", getModuleValue(matrix[row][col]));
-      if (return_value < 0) exitWithIOError(filename);
-    }
-    return_value = fprintf(fp, "%s", "\n");
-    if (return_value < 0) exitWithIOError(filename);
-  }
+  if (writeMatrixAsCSV(fp, matrix) == EOF) exitWithIOError(filename);
   if (fclose(fp) == EOF) exitWithIOError(filename); 
 }
 
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Converts the _MessageData struct \p md to a byte stream considering
-/// the QR-flavor
+/// Layout of the raster formats: the pixels per module and the light modules
+/// around the symbol. A pixel row of the largest layout fits into 
+/// RASTER_MAX_ROW_SIZE bytes, preceded by the filter byte of PNG.
+//
+#define RASTER_DEFAULT_MODULE_SIZE 4
+#define RASTER_MAX_MODULE_SIZE 16
+#define RASTER_DEFAULT_QUIET_ZONE 4
+#define RASTER_MAX_QUIET_ZONE 16
+#define RASTER_MAX_ROW_SIZE (((QR_MAX_MATRIX_SIZE + \
+  2 * RASTER_MAX_QUIET_ZONE) * RASTER_MAX_MODULE_SIZE + 7) / 8)
+
+//------------------------------------------------------------------------------
+///
+/// @brief Expands a module row to a pixel row of 1 bit per pixel, the most 
+/// significant bit first. Every module is replicated to \p module_size bits 
+/// of an accumulator which is emptied byte by byte.
 /// 
-/// @param[out] md_stream A preallocated array to write the stream to
-/// @param md The _MessageData struct to convert
-/// @param flavor The QR-flavor to use
+/// @param matrix The matrix to use
+/// @param row The module row, rows outside of the matrix are light
+/// @param module_size The pixels per module, 1 to RASTER_MAX_MODULE_SIZE
+/// @param quiet_zone The light modules around the symbol
+/// @param dark The pixel value of dark modules, the light ones get the other
+/// @param[out] pixels The pixel row, the last byte is padded with 0 bits
+///
+/// @return The size of the pixel row in bytes
 //
-void generateMessageDataStream(uint8_t *md_stream, struct _MessageData_ *md, 
-struct _QRFlavor_ flavor) 
+size_t expandModuleRow(const struct _QRMatrix_ *matrix, int16_t row, 
+uint8_t module_size, uint8_t quiet_zone, bool dark, unsigned char *pixels)
 {
-  // qr mode and first byte of message
-  md_stream[0] = 0 | (QR_MODE << NIBBLE_SIZE);
-  md_stream[0] |= (md->data_len_ >> NIBBLE_SIZE);
-  md_stream[1] = 0 | (md->data_len_ << NIBBLE_SIZE);
+  const int16_t size = matrix->size_;
+  const uint32_t ones = ((uint32_t)1 << module_size) - 1;
+  unsigned char *position = pixels;
+  uint32_t bits = 0;
+  uint8_t count = 0;
 
-  // the remaining message bytes
-  for (uint8_t counter = 1; counter <= md->data_len_; counter++) 
+  for (int16_t col = -quiet_zone; col < size + quiet_zone; col++)
   {
-    md_stream[counter] |= (md->data_[counter - 1] >> NIBBLE_SIZE);
-    md_stream[counter + 1] = 0 | (md->data_[counter - 1] << NIBBLE_SIZE);
+    const bool module = row >= 0 && row < size && col >= 0 && col < size &&
+      getMatrixModule(matrix, row, col) == 1;
+
+    bits = (bits << module_size) | (module == dark ? ones : 0);
+    count += module_size;
+    while (count >= 8)
+    {
+      count -= 8;
+      *(position++) = bits >> count;
+    }
   }
+  if (count > 0) *(position++) = bits << (8 - count);
+
+  return position - pixels;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Writes the matrix as binary PBM (P4) image to \p fp. Every pixel 
+/// row is expanded once and written for all pixel rows of its module row.
+/// 
+/// @param fp The stream to write to
+/// @param matrix The matrix to use
+/// @param module_size The pixels per module, 1 to RASTER_MAX_MODULE_SIZE
+/// @param quiet_zone The light modules around the symbol, at most 
+/// RASTER_MAX_QUIET_ZONE
+///
+/// @return 0 on success, EOF if writing failed
+//
+int writeMatrixAsPBM(FILE *fp, const struct _QRMatrix_ *matrix, 
+uint8_t module_size, uint8_t quiet_zone)
+{
+  const unsigned width = (matrix->size_ + 2 * quiet_zone) * module_size;
+  unsigned char pixels[RASTER_MAX_ROW_SIZE];
 
-  // terminate with zeros
-  md_stream[md->data_len_+1] &= 0xF0;
+  if (fprintf(fp, "P4\n%u %u\n", width, width) < 0) return EOF;
 
-  // padd with 0xEC11
-  bool flag = true;
-  for (uint8_t counter = md->data_len_ + 2; counter < flavor.capacity_ + 2; 
-    counter++) 
+  for (int16_t row = -quiet_zone; row < matrix->size_ + quiet_zone; row++)
   {
-    md_stream[counter] = (flag) ? 0xEC : 0x11;
-    flag = !flag;
+    const size_t row_size = expandModuleRow(matrix, row, module_size, 
+      quiet_zone, true, pixels);
+
+    for (uint8_t line = 0; line < module_size; line++)
+    {
+      if (fwrite(pixels, 1, row_size, fp) != row_size) return EOF;
+    }
   }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+///
+/// The CRC-32 of PNG chunks, polynomial 0xEDB88320, for every byte value
+//
+static const uint32_t PNG_CRC_TABLE[256] =
+{
+  0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
+  0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
+  0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
+  0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+  0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
+  0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
+  0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
+  0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+  0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
+  0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
+  0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
+  0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+  0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
+  0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
+  0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
+  0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+  0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
+  0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
+  0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
+  0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+  0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
+  0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
+  0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
+  0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+  0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
+  0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
+  0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
+  0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+  0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
+  0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
+  0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
+  0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+  0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
+  0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
+  0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
+  0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+  0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
+  0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
+  0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
+  0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+  0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
+  0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
+  0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+};
+
+//------------------------------------------------------------------------------
+///
+/// Limits of the zlib stream of PNG: the bytes of a stored deflate block and
+/// the modulus of the Adler-32 sums
+//
+#define PNG_MAX_STORED_BLOCK_SIZE 65535
+#define PNG_ADLER_MODULUS 65521
 
+//------------------------------------------------------------------------------
+///
+/// The IDAT chunk of a PNG image while it is written: the image data is 
+/// stored in uncompressed deflate blocks, see writePNGImageData
+//
+struct _PNGStream_
+{
+  FILE *fp_;
+  // CRC-32 of the chunk so far, inverted
+  uint32_t crc_;
+  uint32_t adler_low_;
+  uint32_t adler_high_;
+  // bytes left in the current block and in the image data
+  uint32_t block_left_;
+  size_t data_left_;
 };
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Creates the position patterns within the \p matrix
+/// @brief Updates an inverted CRC-32 with \p size bytes of \p data
 /// 
-/// @param matrix The matrix to use
-/// @param size The matrix size
+/// @param crc The inverted CRC-32 so far
+/// @param data The bytes to add
+/// @param size The number of bytes
+///
+/// @return The updated inverted CRC-32
 //
-void mkPositionPattern(uint8_t **matrix, uint8_t size) 
+static inline uint32_t updatePNGCrc(uint32_t crc, const unsigned char *data, 
+size_t size)
 {
-  for (uint8_t row = 0; row < POS_PATTERN_SIZE; row++)
+  for (size_t index = 0; index < size; index++)
   {
-    memcpy(&(matrix[row][0]), &(POS_PATTERN[row]), sizeof(uint8_t) * 
-      POS_PATTERN_SIZE);
-    memcpy(&(matrix[row][size - POS_PATTERN_SIZE]), &(POS_PATTERN[row]), 
-      sizeof(uint8_t) * POS_PATTERN_SIZE);
-    memcpy(&(matrix[size - POS_PATTERN_SIZE + row][0]), &(POS_PATTERN[row]), 
-      sizeof(uint8_t) * POS_PATTERN_SIZE);
+    crc = PNG_CRC_TABLE[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
   }
+  return crc;
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Creates the separation patterns within the \p matrix
+/// @brief Stores \p value as 32 bit big endian number
 /// 
-/// @param matrix The matrix to use
-/// @param size The matrix size
+/// @param[out] bytes The 4 bytes to write to
+/// @param value The value to store
 //
-void mkSeparationPattern(uint8_t **matrix, uint8_t size)
+static inline void storePNGNumber(unsigned char *bytes, uint32_t value)
 {
-  // horizontal patterns
-  for (uint8_t col = 0; col < POS_PATTERN_SIZE + 1; col++)
-  {
-    setModuleValue(&(matrix[POS_PATTERN_SIZE][col]), 0);
-    setModuleValue(&(matrix[POS_PATTERN_SIZE][size - POS_PATTERN_SIZE - 1 + 
-      col]), 0);
-    setModuleValue(&(matrix[size - POS_PATTERN_SIZE - 1][col]), 0);
-  }
+  bytes[0] = value >> 24;
+  bytes[1] = value >> 16;
+  bytes[2] = value >> 8;
+  bytes[3] = value;
+}
 
-  // vertical patterns
-  for (uint8_t row = 0; row < POS_PATTERN_SIZE; row++)
-  {
-    setModuleValue(&(matrix[row][POS_PATTERN_SIZE]), 0);
-    setModuleValue(&(matrix[row][size - POS_PATTERN_SIZE - 1]), 0);
-    setModuleValue(&(matrix[size - POS_PATTERN_SIZE + row][POS_PATTERN_SIZE]), 
-      0);
-  }
+//------------------------------------------------------------------------------
+///
+/// @brief Writes \p size bytes of the current chunk and adds them to its CRC
+/// 
+/// @param stream The chunk to write to
+/// @param data The bytes to write
+/// @param size The number of bytes
+///
+/// @return 0 on success, EOF if writing failed
+//
+static int writePNGBytes(struct _PNGStream_ *stream, const unsigned char *data,
+size_t size)
+{
+  stream->crc_ = updatePNGCrc(stream->crc_, data, size);
+  return fwrite(data, 1, size, stream->fp_) == size ? 0 : EOF;
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Creates the alignment pattern within the \p matrix
+/// @brief Starts a chunk with its length and type
 /// 
-/// @param matrix The matrix to use
-/// @param size The matrix size
+/// @param[out] stream The chunk to start
+/// @param fp The stream to write to
+/// @param type The 4 letter chunk type
+/// @param size The size of the chunk data
+///
+/// @return 0 on success, EOF if writing failed
 //
-void mkAlignmentPattern(uint8_t **matrix, uint8_t pos)
+static int beginPNGChunk(struct _PNGStream_ *stream, FILE *fp, 
+const char *type, uint32_t size)
 {
-  pos = pos - 2; // offset from pattern midpoint
-  for (uint8_t row = 0; row < ALIGNMENT_PATTERN_SIZE; row++)
-  {
-    memcpy(&(matrix[pos + row][pos]), &(ALIGNMENT_PATTERN[row]), sizeof(uint8_t)
-      * ALIGNMENT_PATTERN_SIZE);
-  }
+  unsigned char length[4];
+
+  stream->fp_ = fp;
+  stream->crc_ = 0xFFFFFFFF;
+  storePNGNumber(length, size);
+  if (fwrite(length, 1, sizeof(length), fp) != sizeof(length)) return EOF;
+  return writePNGBytes(stream, (const unsigned char *)type, 4);
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Creates the sync patterns within the \p matrix
+/// @brief Ends a chunk with its CRC
 /// 
-/// @param matrix The matrix to use
-/// @param size The matrix size
+/// @param stream The chunk to end
+///
+/// @return 0 on success, EOF if writing failed
 //
-void mkSyncPattern(uint8_t **matrix, uint8_t size)
+static int endPNGChunk(struct _PNGStream_ *stream)
 {
-  bool flag = 1;
-  for (uint8_t row_col = POS_PATTERN_SIZE + 1; row_col < size - 1 - 
-    POS_PATTERN_SIZE; row_col++)
-  {
-    // sync row
-    setModuleValue(&(matrix[SYNC_PATTERN_POS][row_col]), flag);
-    // sync column
-    setModuleValue(&(matrix[row_col][SYNC_PATTERN_POS]), flag);
-    flag = !flag;
-  }
+  unsigned char crc[4];
+
+  storePNGNumber(crc, ~stream->crc_);
+  return fwrite(crc, 1, sizeof(crc), stream->fp_) == sizeof(crc) ? 0 : EOF;
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Marks the modules used for format- and version string as taken
+/// @brief Writes \p size bytes of image data into stored deflate blocks, a 
+/// block header is written whenever a block is full
 /// 
-/// @param matrix The matrix to use
-/// @param size The matrix size
+/// @param stream The IDAT chunk to write to
+/// @param data The image data
+/// @param size The number of bytes, at most the data left
+///
+/// @return 0 on success, EOF if writing failed
 //
-void reserveFormatAndVersionModules(uint8_t **matrix, uint8_t size)
+static int writePNGImageData(struct _PNGStream_ *stream, 
+const unsigned char *data, size_t size)
 {
-  uint8_t row = 0;
-  uint8_t col = 0;
-  for (uint8_t row_col = 0; row_col <= POS_PATTERN_SIZE; row_col++)
+  while (size > 0)
   {
-    row = row_col;
-    col = POS_PATTERN_SIZE + 1;
-    // top left vertical
-    if (!isModuleTaken(matrix[row][col])) 
+    if (stream->block_left_ == 0)
     {
-      setModuleTaken(&(matrix[row][col]), 1);
+      // BFINAL, BTYPE 00, then LEN and its complement in little endian
+      const uint16_t length = stream->data_left_ < PNG_MAX_STORED_BLOCK_SIZE ?
+        stream->data_left_ : PNG_MAX_STORED_BLOCK_SIZE;
+      const unsigned char header[5] = {
+        stream->data_left_ <= PNG_MAX_STORED_BLOCK_SIZE, length & 0xFF, 
+        length >> 8, ~length & 0xFF, (uint16_t)~length >> 8};
+
+      if (writePNGBytes(stream, header, sizeof(header)) == EOF) return EOF;
+      stream->block_left_ = length;
     }
 
-    // top left horizontal
-    row = POS_PATTERN_SIZE + 1;
-    col = row_col;
-    if (!isModuleTaken(matrix[row][col])) 
+    const uint32_t part = size < stream->block_left_ ? size : 
+      stream->block_left_;
+    for (uint32_t index = 0; index < part; index++)
     {
-      setModuleTaken(&(matrix[row][col]), 1);
+      stream->adler_low_ += data[index];
+      stream->adler_high_ += stream->adler_low_;
     }
-
-    // top right horizontal
-    row = POS_PATTERN_SIZE + 1;
-    col = size - 1 - POS_PATTERN_SIZE + row_col;
-    setModuleTaken(&(matrix[row][col]), 1);
-
-
-    // bottom left vertical
-    if (row_col == POS_PATTERN_SIZE) continue;
-    row = size - POS_PATTERN_SIZE + row_col;
-    col = POS_PATTERN_SIZE + 1;
-    setModuleTaken(&(matrix[row][col]), 1);
+    // a part of a pixel row is too short to overflow the sums
+    stream->adler_low_ %= PNG_ADLER_MODULUS;
+    stream->adler_high_ %= PNG_ADLER_MODULUS;
+
+    if (writePNGBytes(stream, data, part) == EOF) return EOF;
+    stream->block_left_ -= part;
+    stream->data_left_ -= part;
+    data += part;
+    size -= part;
   }
-
-  // top left corner module
-  setModuleTaken(&(matrix)[POS_PATTERN_SIZE + 1][POS_PATTERN_SIZE + 1], 1);
+  return 0;
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Searches the next free module that can be used for payload data
+/// @brief Writes the matrix as 1 bit grayscale PNG image to \p fp. The image
+/// data is not compressed, every pixel row is expanded once and written for 
+/// all pixel rows of its module row.
 /// 
+/// @param fp The stream to write to
 /// @param matrix The matrix to use
-/// @param size The matrix size
+/// @param module_size The pixels per module, 1 to RASTER_MAX_MODULE_SIZE
+/// @param quiet_zone The light modules around the symbol, at most 
+/// RASTER_MAX_QUIET_ZONE
 ///
-/// @return Returns a pointer to the found module, NULL if none is found
+/// @return 0 on success, EOF if writing failed
 //
-uint8_t *getNextFreeModule(uint8_t **matrix, uint8_t size)
+int writeMatrixAsPNG(FILE *fp, const struct _QRMatrix_ *matrix, 
+uint8_t module_size, uint8_t quiet_zone)
 {
-  static int16_t row = -1;
-  static int16_t col = -1;
-  static int8_t row_direction = UP;
-  static bool next_row = false;
+  static const unsigned char signature[8] = 
+    {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  // width, height, bit depth 1, grayscale, deflate, no filter, no interlace
+  static const unsigned char image_format[5] = {1, 0, 0, 0, 0};
+  // CMF and FLG of a zlib stream with a 32K window and no compression
+  static const unsigned char zlib_header[2] = {0x78, 0x01};
+  const unsigned width = (matrix->size_ + 2 * quiet_zone) * module_size;
+  // every row starts with filter type 0, none
+  const size_t data_size = (size_t)width * ((width + 7) / 8 + 1);
+  const size_t block_count = (data_size + PNG_MAX_STORED_BLOCK_SIZE - 1) /
+    PNG_MAX_STORED_BLOCK_SIZE;
+  unsigned char header[13];
+  unsigned char pixels[RASTER_MAX_ROW_SIZE + 1];
+  unsigned char adler[4];
+  struct _PNGStream_ stream;
+
+  if (fwrite(signature, 1, sizeof(signature), fp) != sizeof(signature)) 
+  {
+    return EOF;
+  }
+
+  storePNGNumber(header, width);
+  storePNGNumber(header + 4, width);
+  memcpy(header + 8, image_format, sizeof(image_format));
+  if (beginPNGChunk(&stream, fp, "IHDR", sizeof(header)) == EOF || 
+      writePNGBytes(&stream, header, sizeof(header)) == EOF ||
+      endPNGChunk(&stream) == EOF) return EOF;
 
+  if (beginPNGChunk(&stream, fp, "IDAT", sizeof(zlib_header) + 
+      5 * block_count + data_size + sizeof(adler)) == EOF ||
+      writePNGBytes(&stream, zlib_header, sizeof(zlib_header)) == EOF) 
+  {
+    return EOF;
+  }
+  stream.adler_low_ = 1;
+  stream.adler_high_ = 0;
+  stream.block_left_ = 0;
+  stream.data_left_ = data_size;
 
-  if (col < 0) col = size - 1;
-  if (row < 0) row = size - 1;
+  pixels[0] = 0;
+  for (int16_t row = -quiet_zone; row < matrix->size_ + quiet_zone; row++)
+  {
+    const size_t row_size = expandModuleRow(matrix, row, module_size, 
+      quiet_zone, false, pixels + 1) + 1;
 
-  while (col >= 0) {
-    if (isModuleTaken(matrix[row][col])) 
+    for (uint8_t line = 0; line < module_size; line++)
     {
-      if (next_row) 
-      {
-        row += row_direction;
-        col++;
-        // change vertical direction and go to the left
-        if (row < 0 || row >= size) {
-          if (row_direction == UP) row_direction = DOWN;
-          else row_direction = UP;
-          row += row_direction;
-          col -= 2;
-          if (col == 6) col--;
-        }
-      } 
-      else 
-      {
-        col--;
-      }
-      next_row = !next_row;
-      continue;
+      if (writePNGImageData(&stream, pixels, row_size) == EOF) return EOF;
     }
-    return &(matrix[row][col]);
   }
-  return NULL;
+
+  storePNGNumber(adler, (stream.adler_high_ << 16) | stream.adler_low_);
+  if (writePNGBytes(&stream, adler, sizeof(adler)) == EOF || 
+      endPNGChunk(&stream) == EOF) return EOF;
+
+  if (beginPNGChunk(&stream, fp, "IEND", 0) == EOF) return EOF;
+  return endPNGChunk(&stream);
 }
 
 //------------------------------------------------------------------------------
-///
-/// @brief Inserts the byte \p data_stream into the matrix
+/// @brief Checks the return codes of the encoder lib and handles the errors
 /// 
-/// @param matrix The matrix to use
-/// @param size The matrix size
-/// @param data_stream The byte stream that should be placed
-/// @param data_size The length of the \p data_stream
+/// @param return_value The return value qrEncode has returned
 //
-void streamToPattern(uint8_t **matrix, uint8_t size, uint8_t *data_stream, 
-uint8_t data_size)
+void checkEncodeReturnValue(int return_value)
 {
-  uint8_t *module = NULL;
-  for (uint8_t counter = 0; counter < data_size; counter++)
+  if (return_value == QR_ENCODE_ERROR_OUT_OF_MEMORY)
   {
-    for (int8_t bit_pos = 7; bit_pos >= 0; bit_pos--)
-    {
-      module = getNextFreeModule(matrix, size);
-      if (module) {
-        setModuleDataValue(module, (data_stream[counter] >> bit_pos) & 1);
-      }
-    }
+    printf("%s", "[ERR] Out of memory.\n");
+    exit(ERR_ECC_OOM);
+  } 
+  else if (return_value == QR_ENCODE_ERROR_DATA_TOO_LONG)
+  {
+    printf("[ERR] Text to encode is too long, max. %i digits, %i "
+           "alphanumeric characters or %i bytes can be encoded.\n", 
+           QR_MAX_INPUT_SIZE, QR_MAX_ALPHANUMERIC_INPUT_SIZE, 
+           QR_MAX_BYTE_INPUT_SIZE);
+    exit(ERR_TEXT_SIZE);
+  }
+  else if (return_value != QR_ENCODE_RETURN_SUCCESSFUL)
+  {
+    printf("%s", "[ERR] Function from errorcorrection library called with "
+           "wrong parameters.\n"
+    );
+    exit(ERR_ECC_PARAMS);
   }
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Inserts the data payload and ec-data into the matrix
+/// @brief Prints the codewords of \p stream as comma separated hex values
 /// 
-/// @param matrix The matrix to use
-/// @param size The matrix size
-/// @param message_data_stream The data byte stream
-/// @param data_size The size of \p message_data_stream
-/// @param ec_data_stream The error correction byte stream
-/// @param ec_data_size The size of \p ec_data_stream
+/// @param stream The codewords to print
+/// @param stream_size The number of codewords
 //
-void mkDataPattern(uint8_t **matrix, uint8_t size, uint8_t *message_data_stream, 
-uint8_t data_size, uint8_t *ec_data_stream, uint8_t ec_data_size)
+void outputCodewords(const uint8_t *stream, uint16_t stream_size)
 {
-  streamToPattern(matrix, size, message_data_stream, data_size);
-  streamToPattern(matrix, size, ec_data_stream, ec_data_size);
+  for (uint16_t counter = 0; counter < stream_size; counter++)
+  {
+    printf("0x%02X", stream[counter]);
+    if (counter < stream_size - 1) printf("%s", ", ");
+  }
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Masks the data modules with the mask pattern
+/// Record stream of the batch mode. A regular input file is mapped and 
+/// records are handed out as slices of the mapping, which stay valid until 
+/// the reader is closed. Other inputs are read in blocks of 
+/// RECORD_BUFFER_SIZE bytes, records are handed out as slices of that block.
+//
+#define RECORD_BUFFER_SIZE (1 << 16)
+#define RECORD_LENGTH_PREFIX_SIZE 4
+
+struct _RecordReader_
+{
+  FILE *fp_;
+  bool length_prefixed_;
+  bool eof_;
+  // the unread bytes of buffer_, or of mapping_ if the input is mapped
+  size_t begin_;
+  size_t end_;
+  const unsigned char *mapping_;
+  size_t mapping_size_;
+  unsigned char buffer_[RECORD_BUFFER_SIZE];
+};
+
+enum
+{
+  RECORD_READ_OK = 0,
+  RECORD_READ_END = 1,
+  RECORD_READ_TOO_LONG = 2,
+  RECORD_READ_ERROR = 3
+};
+
+//------------------------------------------------------------------------------
+///
+/// @brief Moves the unread bytes to the front of the buffer and reads the next
+/// block from the input behind them
 /// 
-/// @param matrix The matrix to use
-/// @param size The matrix size
+/// @param reader The reader to refill
+///
+/// @return Number of bytes read, 0 at the end of the input, -1 on read errors
 //
-void maskData(uint8_t **matrix, uint8_t size)
+int refillRecordBuffer(struct _RecordReader_ *reader)
 {
-  for (uint8_t row = 0; row < size; row++)
+  size_t bytes_read;
+
+  if (reader->eof_) return 0;
+
+  if (reader->begin_ > 0)
   {
-    for (uint8_t col = 0; col < size; col++)
-    {
-      if (getModuleDataFlag(matrix[row][col]) || 
-          !isModuleTaken(matrix[row][col]))
-      {
-        setModuleValue(&(matrix[row][col]), getModuleValue(matrix[row][col]) ^ 
-          ((((col * row) % 2) + ((col * row) % 3)) % 2 == 0 ));
-      }
-    }
+    memmove(reader->buffer_, reader->buffer_ + reader->begin_, 
+      reader->end_ - reader->begin_);
+    reader->end_ -= reader->begin_;
+    reader->begin_ = 0;
+  }
+
+  bytes_read = fread(reader->buffer_ + reader->end_, 1, 
+    RECORD_BUFFER_SIZE - reader->end_, reader->fp_);
+  if (bytes_read == 0)
+  {
+    if (ferror(reader->fp_)) return -1;
+    reader->eof_ = true;
   }
+  reader->end_ += bytes_read;
+  return (int)bytes_read;
 }
 
 //------------------------------------------------------------------------------
 ///
-/// @brief Places the format and version info into the pre-reserved modules
+/// @brief Makes sure \p count unread bytes are in the buffer of \p reader
 /// 
-/// @param matrix The matrix to use
-/// @param size The matrix size
-/// @param format_string The format and version data
+/// @param reader The reader to use
+/// @param count The number of bytes needed, at most RECORD_BUFFER_SIZE
+///
+/// @return RECORD_READ_OK, RECORD_READ_END if the input ended before or 
+/// RECORD_READ_ERROR on read errors
 //
-void mkFormatVersionPattern(uint8_t **matrix, uint8_t size, uint32_t 
-format_string)
+int requireRecordBytes(struct _RecordReader_ *reader, size_t count)
 {
-  uint8_t col, row;
-  for (uint8_t bit_pos = 0; bit_pos < FORMAT_VERSION_LENGTH; bit_pos++)
+  while (reader->end_ - reader->begin_ < count)
   {
-    // first pattern
-    if (bit_pos <= 7)
-    {
-      col = POS_PATTERN_SIZE + 1;
-      row = bit_pos;
-      if (bit_pos >= SYNC_PATTERN_POS) row++;
-    }
-    else 
-    {
-      col = POS_PATTERN_SIZE - (bit_pos - 8);
-      if (col <= SYNC_PATTERN_POS) col--;
-      row = POS_PATTERN_SIZE + 1;
-    }
-    setModuleValue(&(matrix[row][col]), (format_string >> bit_pos) & 1 );
-    
-    // second pattern
-    if (bit_pos <= 7)
-    {
-      col = size - 1 - bit_pos;
-      row = POS_PATTERN_SIZE + 1;
-    }
-    else 
-    {
-      col = POS_PATTERN_SIZE + 1;
-      row = size - 1 - 6 + (bit_pos - 8);
-    }
-    setModuleValue(&(matrix[row][col]), (format_string >> bit_pos) & 1 );
+    int bytes_read = refillRecordBuffer(reader);
+    if (bytes_read < 0) return RECORD_READ_ERROR;
+    if (bytes_read == 0) return RECORD_READ_END;
   }
+  return RECORD_READ_OK;
 }
 
 //------------------------------------------------------------------------------
-/// @brief Checks the return codes of the EC-lib and handles the errors
+///
+/// @brief Reads the next newline terminated record
 /// 
-/// @param return_value The return value the EC-lib has returned
+/// @param reader The reader to use
+/// @param[out] record Points to the record within the reader buffer
+/// @param[out] record_size The record length without the newline
+///
+/// @return One of the RECORD_READ_ codes
 //
-void checkECCReturnValue(int return_value)
+int readLineRecord(struct _RecordReader_ *reader, const unsigned char **record,
+size_t *record_size)
 {
-  if (return_value != ERROR_CORRECTION_RETURN_SUCCESSFUL) 
+  size_t searched = 0;
+  bool too_long = false;
+
+  while (true)
   {
-    if (return_value == ERROR_CORRECTION_ERROR_OUT_OF_MEMORY)
+    unsigned char *start = reader->buffer_ + reader->begin_;
+    unsigned char *newline = memchr(start + searched, '\n', 
+      reader->end_ - reader->begin_ - searched);
+
+    if (newline)
     {
-      printf("%s", "[ERR] Out of memory.\n");
-      exit(ERR_ECC_OOM);
-    } 
-    else if (return_value == ERROR_CORRECTION_ERROR_INVALID_PARAMETER)
+      *record = start;
+      *record_size = newline - start;
+      reader->begin_ += *record_size + 1;
+      return too_long ? RECORD_READ_TOO_LONG : RECORD_READ_OK;
+    }
+
+    if (reader->begin_ == 0 && reader->end_ == RECORD_BUFFER_SIZE)
+    {
+      // a record which does not fit into the buffer is skipped
+      too_long = true;
+      reader->begin_ = reader->end_;
+    }
+    searched = reader->end_ - reader->begin_;
+
+    int bytes_read = refillRecordBuffer(reader);
+    if (bytes_read < 0) return RECORD_READ_ERROR;
+    if (bytes_read == 0)
     {
-      printf("%s", "[ERR] Function from errorcorrection library called with "
-             "wrong parameters.\n"
-      );
-      exit(ERR_ECC_PARAMS);
+      // last record without a trailing newline
+      if (reader->begin_ == reader->end_ && !too_long) return RECORD_READ_END;
+      *record = reader->buffer_ + reader->begin_;
+      *record_size = reader->end_ - reader->begin_;
+      reader->begin_ = reader->end_;
+      return too_long ? RECORD_READ_TOO_LONG : RECORD_READ_OK;
     }
   }
 }
 
 //------------------------------------------------------------------------------
 ///
-/// The main program.
-/// Reads a string an generates a corresponding QR-code 
+/// @brief Reads the next record which is prefixed by its length as 32 bit big
+/// endian number
+/// 
+/// @param reader The reader to use
+/// @param[out] record Points to the record within the reader buffer
+/// @param[out] record_size The record length
 ///
-/// @param argc Could be used for bonus points - we don't use it
-/// @param argv Could be used for bonus points - we don't use it
-///
-/// @return 0 on success, otherwise error code according to error codes enum and
-/// the error that occured
+/// @return One of the RECORD_READ_ codes
 //
-int main(int argc, char** argv)
+int readLengthPrefixedRecord(struct _RecordReader_ *reader, 
+const unsigned char **record, size_t *record_size)
 {
-  unsigned char input_string[MAX_INPUT_STRING_SIZE + 1];
-  int input;
-  uint8_t len = 0;
-  struct _QRFlavor_ flavor_to_use;
-  struct _MessageData_ MessageData;
-  uint8_t *message_data_stream;
-  uint8_t *ec_data;
-  uint8_t size;
-  uint8_t **matrix;
-  uint32_t format_string;
-  uint8_t ec_level;
   int return_value;
-  bool write_svg = false;
-  bool write_csv = false;
-  char filename[256];
+  uint32_t length = 0;
 
-  if (argc > 3) 
+  return_value = requireRecordBytes(reader, RECORD_LENGTH_PREFIX_SIZE);
+  if (return_value == RECORD_READ_END && reader->begin_ != reader->end_)
   {
-    printf("%s", "Usage: ./ass3 [-b FILENAME]\n");
-    exit(ERR_PARAMS);
-  } 
-  else if (argc == 3 && strcmp(argv[1], "-b") == 0)
+    return RECORD_READ_ERROR; // truncated length prefix
+  }
+  if (return_value != RECORD_READ_OK) return return_value;
+
+  for (uint8_t counter = 0; counter < RECORD_LENGTH_PREFIX_SIZE; counter++)
   {
-    write_svg = true;
-    strcpy(filename, argv[2]);
+    length = (length << 8) | reader->buffer_[reader->begin_ + counter];
   }
-  else if (argc == 3 && strcmp(argv[1], "-c") == 0)
+  reader->begin_ += RECORD_LENGTH_PREFIX_SIZE;
+
+  if (length > RECORD_BUFFER_SIZE)
   {
-    write_csv = true;
-    strcpy(filename, argv[2]);
+    // a record which does not fit into the buffer is skipped
+    while (length > 0)
+    {
+      size_t available = reader->end_ - reader->begin_;
+      size_t skip = available < length ? available : length;
+      reader->begin_ += skip;
+      length -= skip;
+      if (length > 0 && refillRecordBuffer(reader) <= 0) 
+      {
+        return RECORD_READ_ERROR;
+      }
+    }
+    return RECORD_READ_TOO_LONG;
   }
 
-  printf("--- QR-Code Encoder ---\n\nPlease enter a text:\n");
+  return_value = requireRecordBytes(reader, length);
+  if (return_value != RECORD_READ_OK) return RECORD_READ_ERROR;
 
-  do 
+  *record = reader->buffer_ + reader->begin_;
+  *record_size = length;
+  reader->begin_ += length;
+  return RECORD_READ_OK;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Reads the next newline terminated record of a mapped input. The
+/// newline is found by memchr, which scans whole vector registers at once.
+/// 
+/// @param reader The reader to use
+/// @param[out] record Points to the record within the mapping
+/// @param[out] record_size The record length without the newline
+///
+/// @return One of the RECORD_READ_ codes
+//
+int readMappedLineRecord(struct _RecordReader_ *reader, 
+const unsigned char **record, size_t *record_size)
+{
+  const unsigned char *start = reader->mapping_ + reader->begin_;
+  const size_t available = reader->end_ - reader->begin_;
+  const unsigned char *newline;
+
+  if (available == 0) return RECORD_READ_END;
+
+  // the last record may lack the newline
+  newline = memchr(start, '\n', available);
+  *record = start;
+  *record_size = newline ? (size_t)(newline - start) : available;
+  reader->begin_ += *record_size + (newline ? 1 : 0);
+  return RECORD_READ_OK;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Reads the next length prefixed record of a mapped input, see 
+/// readLengthPrefixedRecord
+/// 
+/// @param reader The reader to use
+/// @param[out] record Points to the record within the mapping
+/// @param[out] record_size The record length
+///
+/// @return One of the RECORD_READ_ codes
+//
+int readMappedLengthPrefixedRecord(struct _RecordReader_ *reader, 
+const unsigned char **record, size_t *record_size)
+{
+  const unsigned char *start = reader->mapping_ + reader->begin_;
+  const size_t available = reader->end_ - reader->begin_;
+  uint32_t length = 0;
+
+  if (available == 0) return RECORD_READ_END;
+  if (available < RECORD_LENGTH_PREFIX_SIZE) return RECORD_READ_ERROR;
+
+  for (uint8_t counter = 0; counter < RECORD_LENGTH_PREFIX_SIZE; counter++)
   {
-    input = fgetc(stdin);
-    if (input == '\n' || input == EOF) break;
-    if (len == MAX_INPUT_STRING_SIZE)
+    length = (length << 8) | start[counter];
+  }
+  if (length > available - RECORD_LENGTH_PREFIX_SIZE) return RECORD_READ_ERROR;
+
+  *record = start + RECORD_LENGTH_PREFIX_SIZE;
+  *record_size = length;
+  reader->begin_ += RECORD_LENGTH_PREFIX_SIZE + length;
+  return RECORD_READ_OK;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Reads the next record of the batch input
+/// 
+/// @param reader The reader to use
+/// @param[out] record Points to the record, valid until the next call unless
+/// the input is mapped
+/// @param[out] record_size The record length
+///
+/// @return One of the RECORD_READ_ codes
+//
+int readRecord(struct _RecordReader_ *reader, const unsigned char **record,
+size_t *record_size)
+{
+  if (reader->mapping_)
+  {
+    if (reader->length_prefixed_) 
     {
-      printf("[ERR] Text to encode is too long, max. 106 bytes can be "
-             "encoded.\n"
-      );
-      exit(ERR_TEXT_SIZE);
+      return readMappedLengthPrefixedRecord(reader, record, record_size);
     }
-    input_string[len] = input;
-    len++;
+    return readMappedLineRecord(reader, record, record_size);
   }
-  while(true);
-  input_string[len] = '\0';
+  if (reader->length_prefixed_) 
+  {
+    return readLengthPrefixedRecord(reader, record, record_size);
+  }
+  return readLineRecord(reader, record, record_size);
+}
 
-  printf("\nMessage: %s\nLength: %i\n\n", input_string, len);
+//------------------------------------------------------------------------------
+///
+/// @brief Initializes \p reader for \p input. A regular file is mapped from
+/// its current position on and read sequentially, other inputs and files 
+/// which cannot be mapped are read in blocks.
+/// 
+/// @param[out] reader The reader to initialize
+/// @param input The stream to read the records from
+/// @param length_prefixed Whether the records are length prefixed instead of
+/// newline terminated
+//
+void openRecordReader(struct _RecordReader_ *reader, FILE *input, 
+bool length_prefixed)
+{
+  const off_t position = ftello(input);
+  struct stat status;
+  void *mapping;
+
+  reader->fp_ = input;
+  reader->length_prefixed_ = length_prefixed;
+  reader->eof_ = false;
+  reader->begin_ = reader->end_ = 0;
+  reader->mapping_ = NULL;
+  reader->mapping_size_ = 0;
+
+  if (position < 0 || fstat(fileno(input), &status) != 0 || 
+      !S_ISREG(status.st_mode) || status.st_size <= position) return;
+
+  mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, 
+    fileno(input), 0);
+  if (mapping == MAP_FAILED) return;
+
+  // the pages are read ahead and may be dropped soon after they were read
+  madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+  reader->mapping_ = mapping;
+  reader->mapping_size_ = status.st_size;
+  reader->begin_ = position;
+  reader->end_ = status.st_size;
+}
 
-  for (uint8_t counter = 0; counter < NUMBER_OF_QR_FLAVORS; counter++) 
+//------------------------------------------------------------------------------
+///
+/// @brief Unmaps the input of \p reader, if it is mapped
+/// 
+/// @param reader The reader to close
+//
+void closeRecordReader(struct _RecordReader_ *reader)
+{
+  if (reader->mapping_) 
   {
-      if (QRFlavors[counter].capacity_ < len) continue;
-      flavor_to_use = QRFlavors[counter];
-      break;
+    munmap((void *)reader->mapping_, reader->mapping_size_);
   }
+}
+
+//------------------------------------------------------------------------------
+///
+/// Output formats of the batch mode
+//
+enum
+{
+  FORMAT_TEXT = 0,
+  FORMAT_SVG = 1,
+  FORMAT_CSV = 2,
+  FORMAT_PBM = 3,
+  FORMAT_PNG = 4
+};
 
-  printf("QR-Code: %i-%c\n\n", flavor_to_use.version_, flavor_to_use.ec_level_);
+const char *FORMAT_NAMES[] = {"text", "svg", "csv", "pbm", "png"};
+const char *FORMAT_EXTENSIONS[] = {"txt", "svg", "csv", "pbm", "png"};
 
-  MessageData.mode_ = QR_MODE;
-  MessageData.data_len_ = len;
-  MessageData.data_ = malloc(sizeof(char)*len);
+//------------------------------------------------------------------------------
+///
+/// Output format of the batch mode
+//
+struct _OutputFormat_
+{
+  // one of the FORMAT_ constants
+  int type_;
+  // layout of FORMAT_PBM and FORMAT_PNG, see RASTER_MAX_MODULE_SIZE
+  uint8_t module_size_;
+  uint8_t quiet_zone_;
+};
 
-  for (uint8_t counter = 0; counter < len; counter++)
+//------------------------------------------------------------------------------
+///
+/// @brief Writes the \p matrix in the given \p format to \p fp
+/// 
+/// @param fp The stream to write to
+/// @param matrix The matrix to write
+/// @param format The output format
+///
+/// @return 0 on success, EOF if writing failed
+//
+int writeMatrix(FILE *fp, const struct _QRMatrix_ *matrix, 
+const struct _OutputFormat_ *format)
+{
+  switch (format->type_)
   {
-    MessageData.data_[counter] = input_string[counter];
+    case FORMAT_SVG:
+      return writeMatrixAsSVG(fp, matrix);
+    case FORMAT_CSV:
+      return writeMatrixAsCSV(fp, matrix);
+    case FORMAT_PBM:
+      return writeMatrixAsPBM(fp, matrix, format->module_size_, 
+        format->quiet_zone_);
+    case FORMAT_PNG:
+      return writeMatrixAsPNG(fp, matrix, format->module_size_, 
+        format->quiet_zone_);
+    default:
+      return writeMatrixAsText(fp, matrix);
   }
+}
 
-  // data block
-  message_data_stream = malloc(sizeof(uint8_t) * (flavor_to_use.capacity_ + 2));
-  generateMessageDataStream(message_data_stream, &MessageData, flavor_to_use);
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the name of the file a record is written to in directory 
+/// mode
+/// 
+/// @param[out] filename The buffer to write the name to
+/// @param filename_size The size of \p filename
+/// @param directory The output directory
+/// @param record_number The number of the record, starting at 1
+/// @param format The output format
+//
+void getRecordFilename(char *filename, size_t filename_size, 
+const char *directory, unsigned long record_number, 
+const struct _OutputFormat_ *format)
+{
+  snprintf(filename, filename_size, "%s/%08lu.%s", directory, record_number, 
+    FORMAT_EXTENSIONS[format->type_]);
+}
 
-  printf("Message data codewords:\n");
-  for (uint8_t counter = 0; counter < flavor_to_use.capacity_ + 2; counter++)
+//------------------------------------------------------------------------------
+///
+/// @brief Converts the return value of qrEncode for a record of the batch mode
+/// 
+/// @param return_value The return value qrEncode has returned
+///
+/// @return 0 on success, otherwise error code according to error codes enum
+//
+int getRecordResult(int return_value)
+{
+  if (return_value == QR_ENCODE_ERROR_DATA_TOO_LONG) return ERR_TEXT_SIZE;
+  if (return_value == QR_ENCODE_ERROR_OUT_OF_MEMORY) return ERR_ECC_OOM;
+  if (return_value != QR_ENCODE_RETURN_SUCCESSFUL) return ERR_ECC_PARAMS;
+  return ERR_NO_ERROR;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Writes an encoded record of the batch mode either to \p output, 
+/// the text formats followed by an empty line and the images back to back, 
+/// or into its own file in \p directory
+/// 
+/// @param code The encoded QR-Code of the record
+/// @param record_number The number of the record, starting at 1
+/// @param output The stream to write to, unused if \p directory is set
+/// @param directory The directory to write to, or NULL
+/// @param format The output format
+///
+/// @return 0 on success, otherwise error code according to error codes enum
+//
+int writeRecord(const struct _QRCode_ *code, unsigned long record_number, 
+FILE *output, const char *directory, const struct _OutputFormat_ *format)
+{
+  char filename[4096];
+  int return_value;
+
+  if (directory)
   {
-    printf("0x%02X", message_data_stream[counter]);
-    if (counter < flavor_to_use.capacity_ + 1) printf("%s", ", ");
+    getRecordFilename(filename, sizeof(filename), directory, record_number, 
+      format);
+    FILE *fp = fopen(filename, "w");
+    if (!fp) return ERR_IO;
+    return_value = writeMatrix(fp, &(code->matrix_), format);
+    if (fclose(fp) == EOF || return_value == EOF) return ERR_IO;
+    return ERR_NO_ERROR;
   }
-  printf("%s", "\n");
 
+  if (writeMatrix(output, &(code->matrix_), format) == EOF) return ERR_IO;
+  if (format->type_ != FORMAT_PBM && format->type_ != FORMAT_PNG &&
+      fputc('\n', output) == EOF) return ERR_IO;
+  return ERR_NO_ERROR;
+}
 
-  // error correction
-  ec_data = malloc(sizeof(uint8_t) * flavor_to_use.ec_data_);
-  return_value = generateErrorCorrectionCodewords(ec_data, 
-    flavor_to_use.ec_data_, message_data_stream, flavor_to_use.capacity_ + 2);
-  checkECCReturnValue(return_value);
+//------------------------------------------------------------------------------
+///
+/// @brief Reports a failed record of the batch mode. Records which are too 
+/// long are skipped, all other errors end the program.
+/// 
+/// @param result The error code of the record
+/// @param record_number The number of the record, starting at 1
+/// @param directory The output directory, or NULL
+/// @param format The output format
+///
+/// @return \p result if the batch can continue, ERR_IO for write errors on the
+/// output stream which are handled by the caller
+//
+int handleRecordError(int result, unsigned long record_number, 
+const char *directory, const struct _OutputFormat_ *format)
+{
+  char filename[4096];
 
-  printf("Error correction codewords:\n");
-  for (uint8_t counter = 0; counter < flavor_to_use.ec_data_; counter++)
+  switch (result)
   {
-    printf("0x%02X", ec_data[counter]);
-    if (counter < flavor_to_use.ec_data_ - 1) printf("%s", ", ");
+    case ERR_TEXT_SIZE:
+      fprintf(stderr, "[ERR] Record %lu is too long, max. %i digits, %i "
+              "alphanumeric characters or %i bytes can be encoded.\n", 
+              record_number, QR_MAX_INPUT_SIZE, 
+              QR_MAX_ALPHANUMERIC_INPUT_SIZE, QR_MAX_BYTE_INPUT_SIZE);
+      return result;
+    case ERR_IO:
+      if (!directory) return result;
+      getRecordFilename(filename, sizeof(filename), directory, record_number,
+        format);
+      exitWithIOError(filename);
+      return result;
+    case ERR_ECC_OOM:
+      checkEncodeReturnValue(QR_ENCODE_ERROR_OUT_OF_MEMORY);
+      return result;
+    default:
+      checkEncodeReturnValue(QR_ENCODE_ERROR_INVALID_PARAMETER);
+      return result;
   }
-  printf("%s", "\n");
+}
 
 
-  // message
-  printf("Data codewords:\n");
-  for (uint8_t counter = 0; counter < flavor_to_use.capacity_ + 2; counter++)
+//------------------------------------------------------------------------------
+///
+/// Batch mode. The records are read in chunks of up to BATCH_CHUNK_RECORDS,
+/// their payloads are stored back to back in BATCH_CHUNK_PAYLOAD_SIZE bytes.
+/// The records are encoded in groups of QR_MAX_BATCH_CODES, see 
+/// qrEncodeBatch. With a prefix the records are appended to it and encoded 
+/// from templates, see _TemplateCache_. In the parallel batch mode the workers
+/// encode one chunk while the main thread writes the results of the previous 
+/// chunk in input order and reads the next one.
+//
+#define BATCH_CHUNK_RECORDS 1024
+#define BATCH_CHUNK_PAYLOAD_SIZE (1 << 17)
+#define OUTPUT_ARENA_MIN_CAPACITY (1 << 16)
+
+//------------------------------------------------------------------------------
+///
+/// Buffer a worker renders its records of a chunk into. The arena is emptied 
+/// once the chunk is written and only freed at the end of the batch, so it 
+/// stops allocating as soon as it has grown to the output of a chunk.
+//
+struct _OutputArena_
+{
+  char *data_;
+  size_t size_;
+  size_t capacity_;
+  // appends to data_, see openOutputArena
+  FILE *stream_;
+};
+
+struct _BatchRecord_
+{
+  // within the payloads of the chunk, or within the mapped input
+  const unsigned char *payload_;
+  unsigned long number_;
+  size_t size_;
+  // error code according to error codes enum
+  int result_;
+  // rendered output, output_size_ bytes at output_offset_ in the output 
+  // arena of the worker output_arena_
+  unsigned output_arena_;
+  size_t output_offset_;
+  size_t output_size_;
+};
+
+struct _BatchChunk_
+{
+  size_t count_;
+  // a read error ends the batch after the records of this chunk
+  bool read_error_;
+  // one output arena per worker, unused by the serial batch mode
+  struct _OutputArena_ *arenas_;
+  unsigned arena_count_;
+  struct _BatchRecord_ records_[BATCH_CHUNK_RECORDS];
+  unsigned char payloads_[BATCH_CHUNK_PAYLOAD_SIZE];
+};
+
+//------------------------------------------------------------------------------
+///
+/// @brief Write function of the stream of an _OutputArena_, appends 
+/// \p buffer to the arena
+/// 
+/// @param cookie The arena
+/// @param buffer The bytes to append
+/// @param size The number of bytes
+///
+/// @return The number of bytes written, 0 if the arena could not grow
+//
+ssize_t writeOutputArena(void *cookie, const char *buffer, size_t size)
+{
+  struct _OutputArena_ *arena = cookie;
+
+  if (arena->size_ + size > arena->capacity_)
   {
-    printf("0x%02X", message_data_stream[counter]);
-    printf("%s", ", ");
+    size_t capacity = arena->capacity_ ? arena->capacity_ : 
+      OUTPUT_ARENA_MIN_CAPACITY;
+    while (capacity < arena->size_ + size) capacity *= 2;
+
+    char *data = realloc(arena->data_, capacity);
+    if (!data) return 0;
+    arena->data_ = data;
+    arena->capacity_ = capacity;
   }
-  
-  for (uint8_t counter = 0; counter < flavor_to_use.ec_data_; counter++)
+  memcpy(arena->data_ + arena->size_, buffer, size);
+  arena->size_ += size;
+  return size;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Initializes an empty \p arena and opens its stream
+/// 
+/// @param[out] arena The arena to open
+///
+/// @return true on success, false if the stream could not be opened
+//
+bool openOutputArena(struct _OutputArena_ *arena)
+{
+  cookie_io_functions_t functions = {.write = writeOutputArena};
+
+  arena->data_ = NULL;
+  arena->size_ = 0;
+  arena->capacity_ = 0;
+  arena->stream_ = fopencookie(arena, "w", functions);
+  return arena->stream_ != NULL;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Closes the stream of \p arena and frees its buffer
+/// 
+/// @param arena The arena to close
+//
+void closeOutputArena(struct _OutputArena_ *arena)
+{
+  if (arena->stream_) fclose(arena->stream_);
+  free(arena->data_);
+}
+
+//------------------------------------------------------------------------------
+///
+/// Templates of the payloads with a common prefix, one per payload length. 
+/// The templates are created on first use, see qrCreateTemplate, so every
+/// record only pays for the codewords that differ from its template.
+//
+struct _TemplateCache_
+{
+  // NULL if the records are encoded without prefix
+  const unsigned char *prefix_;
+  size_t prefix_length_;
+  // the templates are byte mode, see qrCreateTemplate
+  struct _QRTemplate_ *templates_[QR_MAX_BYTE_INPUT_SIZE + 1];
+};
+
+//------------------------------------------------------------------------------
+///
+/// @brief Initializes an empty template cache
+/// 
+/// @param[out] cache The cache to initialize
+/// @param prefix The prefix of all records, or NULL
+//
+void initTemplateCache(struct _TemplateCache_ *cache, const char *prefix)
+{
+  cache->prefix_ = (const unsigned char *)prefix;
+  cache->prefix_length_ = prefix ? strlen(prefix) : 0;
+  for (size_t len = 0; len <= QR_MAX_BYTE_INPUT_SIZE; len++)
   {
-    printf("0x%02X", ec_data[counter]);
-    if (counter < flavor_to_use.ec_data_ - 1) printf("%s", ", ");
+    cache->templates_[len] = NULL;
   }
-  printf("%s", "\n");
+}
 
-  size = 21 + 4 * (flavor_to_use.version_ - 1);
+//------------------------------------------------------------------------------
+///
+/// @brief Frees all templates of \p cache
+/// 
+/// @param cache The cache to free
+//
+void freeTemplateCache(struct _TemplateCache_ *cache)
+{
+  for (size_t len = 0; len <= QR_MAX_BYTE_INPUT_SIZE; len++)
+  {
+    if (!cache->templates_[len]) continue;
+    qrFreeTemplate(cache->templates_[len]);
+    free(cache->templates_[len]);
+    cache->templates_[len] = NULL;
+  }
+}
 
-  //printf("size: %i\n", size);
+//------------------------------------------------------------------------------
+///
+/// @brief Encodes the prefix of \p cache followed by \p suffix, the template 
+/// of the payload length is created if it is not cached yet
+/// 
+/// @param cache The cache to use
+/// @param suffix The record appended to the prefix
+/// @param suffix_len The record length in bytes
+/// @param[out] code The encoded QR-Code
+///
+/// @return error code according to error codes enum
+//
+int encodeTemplateRecord(struct _TemplateCache_ *cache, 
+const unsigned char *suffix, size_t suffix_len, struct _QRCode_ *code)
+{
+  const size_t len = cache->prefix_length_ + suffix_len;
+  struct _QRTemplate_ *qr_template;
+  int return_value;
 
-  // allocate memory for 2-dimensional matrix array
-  matrix = malloc(sizeof(uint8_t*) * size);
-  for (uint8_t row = 0; row < size; row++)
+  if (len > QR_MAX_BYTE_INPUT_SIZE) return ERR_TEXT_SIZE;
+
+  qr_template = cache->templates_[len];
+  if (!qr_template)
   {
-    matrix[row] = malloc(sizeof(uint8_t*) * size);
-    // initialize the newly allocated memory to zero
-    memset((matrix[row]), 0, sizeof(uint8_t*) * size);
+    qr_template = malloc(sizeof(struct _QRTemplate_));
+    if (!qr_template) return ERR_ECC_OOM;
+
+    return_value = qrCreateTemplate(qr_template, cache->prefix_, 
+      cache->prefix_length_, len, NULL);
+    if (return_value != QR_ENCODE_RETURN_SUCCESSFUL)
+    {
+      free(qr_template);
+      return getRecordResult(return_value);
+    }
+    cache->templates_[len] = qr_template;
   }
-  
-  mkPositionPattern(matrix, size);
 
-  mkSeparationPattern(matrix, size);
+  return getRecordResult(qrEncodeFromTemplate(qr_template, suffix, code));
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Encodes the records \p first to \p first + \p count - 1 of \p chunk
+/// together, failed records get their error code
+/// 
+/// @param chunk The chunk of the records
+/// @param first The index of the first record within the chunk
+/// @param count The number of records, up to QR_MAX_BATCH_CODES
+/// @param templates The templates to use if the records have a prefix
+/// @param[out] codes The encoded QR-Codes, one per record
+//
+void encodeBatchRecords(struct _BatchChunk_ *chunk, size_t first, size_t count,
+struct _TemplateCache_ *templates, struct _QRCode_ *codes)
+{
+  const unsigned char *payloads[QR_MAX_BATCH_CODES] = {NULL};
+  size_t lengths[QR_MAX_BATCH_CODES] = {0};
+  int return_values[QR_MAX_BATCH_CODES];
+  struct _BatchRecord_ *records = chunk->records_ + first;
 
-  if (flavor_to_use.alignment_pattern_pos_)
+  if (templates->prefix_)
   {
-    mkAlignmentPattern(matrix, flavor_to_use.alignment_pattern_pos_);
+    for (size_t index = 0; index < count; index++)
+    {
+      if (records[index].result_ != ERR_NO_ERROR) continue;
+      records[index].result_ = encodeTemplateRecord(templates, 
+        records[index].payload_, records[index].size_, 
+        &(codes[index]));
+    }
+    return;
   }
-  
-  mkSyncPattern(matrix, size);
 
-  // add fixed black module
-  setModuleValue(&(matrix[4 * flavor_to_use.version_ + 9][8]), 1);
+  // records which have already failed are encoded empty and stay failed
+  for (size_t index = 0; index < count; index++)
+  {
+    payloads[index] = records[index].payload_;
+    lengths[index] = records[index].result_ == ERR_NO_ERROR ? 
+      records[index].size_ : 0;
+  }
 
-  reserveFormatAndVersionModules(matrix, size);
+  if (qrEncodeBatch(payloads, lengths, count, NULL, codes, return_values) != 
+      QR_ENCODE_RETURN_SUCCESSFUL)
+  {
+    for (size_t index = 0; index < count; index++)
+    {
+      return_values[index] = QR_ENCODE_ERROR_INVALID_PARAMETER;
+    }
+  }
 
-  mkDataPattern(matrix, size, message_data_stream, flavor_to_use.capacity_ + 2, 
-    ec_data, flavor_to_use.ec_data_);
+  for (size_t index = 0; index < count; index++)
+  {
+    if (records[index].result_ != ERR_NO_ERROR) continue;
+    records[index].result_ = getRecordResult(return_values[index]);
+  }
+}
 
-  printf("%s", "\nData matrix:\n");
-  outputMatrix(matrix, size);
+//------------------------------------------------------------------------------
+///
+/// Range of chunk records owned by one worker. The owner takes records from
+/// the front, idle workers steal from the back.
+//
+struct _WorkQueue_
+{
+  pthread_mutex_t lock_;
+  size_t begin_;
+  size_t end_;
+};
 
-  maskData(matrix, size);
+struct _BatchPool_
+{
+  pthread_mutex_t lock_;
+  pthread_cond_t work_ready_;
+  pthread_cond_t work_done_;
+  // incremented for every submitted chunk
+  unsigned long generation_;
+  unsigned busy_workers_;
+  bool shutdown_;
+  struct _BatchChunk_ *chunk_;
+  unsigned worker_count_;
+  struct _WorkQueue_ *queues_;
+  const char *prefix_;
+  const char *directory_;
+  const struct _OutputFormat_ *format_;
+};
 
-  switch (flavor_to_use.ec_level_) {
-    case 'L':
-      ec_level = 0;
-      break;
-    case 'M':
-      ec_level = 1;
-      break;
-    case 'Q':
-      ec_level = 2;
-      break;
-    case 'H':
-      ec_level = 3;
+struct _BatchWorker_
+{
+  struct _BatchPool_ *pool_;
+  unsigned index_;
+  pthread_t thread_;
+};
+
+//------------------------------------------------------------------------------
+///
+/// @brief Takes the next records for worker \p index, up to 
+/// QR_MAX_BATCH_CODES from the front of its own queue first, then from the 
+/// back of the other queues
+/// 
+/// @param pool The pool to use
+/// @param index The index of the worker
+/// @param[out] first The index of the first taken record within the chunk
+/// @param[out] count The number of taken records
+///
+/// @return true if records were taken, false if all queues are empty
+//
+bool takeBatchRecords(struct _BatchPool_ *pool, unsigned index, 
+size_t *first, size_t *count)
+{
+  for (unsigned counter = 0; counter < pool->worker_count_; counter++)
+  {
+    const unsigned victim = (index + counter) % pool->worker_count_;
+    struct _WorkQueue_ *queue = &(pool->queues_[victim]);
+    bool taken = false;
+
+    pthread_mutex_lock(&(queue->lock_));
+    if (queue->begin_ < queue->end_)
+    {
+      const size_t available = queue->end_ - queue->begin_;
+      *count = available < QR_MAX_BATCH_CODES ? available : QR_MAX_BATCH_CODES;
+      if (victim == index)
+      {
+        *first = queue->begin_;
+        queue->begin_ += *count;
+      }
+      else
+      {
+        queue->end_ -= *count;
+        *first = queue->end_;
+      }
+      taken = true;
+    }
+    pthread_mutex_unlock(&(queue->lock_));
+    if (taken) return true;
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Writes one encoded record of the current chunk. Unless the pool 
+/// writes to a directory, the result is rendered into the output arena of the
+/// worker for the main thread.
+/// 
+/// @param pool The pool to use
+/// @param index The index of the worker
+/// @param code The encoded QR-Code of the record
+/// @param record The record to write
+//
+void renderBatchRecord(struct _BatchPool_ *pool, unsigned index, 
+const struct _QRCode_ *code, struct _BatchRecord_ *record)
+{
+  struct _OutputArena_ *arena = &(pool->chunk_->arenas_[index]);
+
+  if (record->result_ != ERR_NO_ERROR) return;
+
+  if (pool->directory_)
+  {
+    record->result_ = writeRecord(code, record->number_, NULL, 
+      pool->directory_, pool->format_);
+    return;
+  }
+
+  record->output_arena_ = index;
+  record->output_offset_ = arena->size_;
+  record->result_ = writeRecord(code, record->number_, arena->stream_, NULL, 
+    pool->format_);
+
+  // the arena only grows when the stream is flushed
+  if (fflush(arena->stream_) == EOF && record->result_ == ERR_NO_ERROR) 
+  {
+    record->result_ = ERR_ECC_OOM;
+  }
+  if (record->result_ != ERR_NO_ERROR) clearerr(arena->stream_);
+  record->output_size_ = arena->size_ - record->output_offset_;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Thread function of a worker, encodes records of every submitted 
+/// chunk until the pool is shut down
+/// 
+/// @param argument The struct _BatchWorker_ of the thread
+///
+/// @return NULL
+//
+void *runBatchWorker(void *argument)
+{
+  struct _BatchWorker_ *worker = argument;
+  struct _BatchPool_ *pool = worker->pool_;
+  unsigned long generation = 0;
+  size_t first, count;
+  struct _QRCode_ *codes = malloc(sizeof(struct _QRCode_) * 
+    QR_MAX_BATCH_CODES);
+  struct _TemplateCache_ templates;
+
+  initTemplateCache(&templates, pool->prefix_);
+  pthread_mutex_lock(&(pool->lock_));
+  while (true)
+  {
+    while (pool->generation_ == generation && !pool->shutdown_)
+    {
+      pthread_cond_wait(&(pool->work_ready_), &(pool->lock_));
+    }
+    if (pool->shutdown_) break;
+    generation = pool->generation_;
+    pthread_mutex_unlock(&(pool->lock_));
+
+    while (takeBatchRecords(pool, worker->index_, &first, &count))
+    {
+      struct _BatchRecord_ *records = pool->chunk_->records_ + first;
+      if (codes) 
+      {
+        encodeBatchRecords(pool->chunk_, first, count, &templates, codes);
+      }
+      for (size_t index = 0; index < count; index++)
+      {
+        if (codes) 
+        {
+          renderBatchRecord(pool, worker->index_, &(codes[index]), 
+            &(records[index]));
+        }
+        else records[index].result_ = ERR_ECC_OOM;
+      }
+    }
+
+    pthread_mutex_lock(&(pool->lock_));
+    if (--pool->busy_workers_ == 0) pthread_cond_signal(&(pool->work_done_));
+  }
+  pthread_mutex_unlock(&(pool->lock_));
+
+  freeTemplateCache(&templates);
+  free(codes);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Hands \p chunk to the workers, every worker queue gets an equal 
+/// share of its records
+/// 
+/// @param pool The pool to use
+/// @param chunk The chunk to encode
+//
+void submitBatchChunk(struct _BatchPool_ *pool, struct _BatchChunk_ *chunk)
+{
+  pthread_mutex_lock(&(pool->lock_));
+  pool->chunk_ = chunk;
+  for (unsigned index = 0; index < pool->worker_count_; index++)
+  {
+    pool->queues_[index].begin_ = chunk->count_ * index / pool->worker_count_;
+    pool->queues_[index].end_ = chunk->count_ * (index + 1) / 
+      pool->worker_count_;
+  }
+  pool->busy_workers_ = pool->worker_count_;
+  pool->generation_++;
+  pthread_cond_broadcast(&(pool->work_ready_));
+  pthread_mutex_unlock(&(pool->lock_));
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Waits until the workers have finished the submitted chunk
+/// 
+/// @param pool The pool to use
+//
+void waitForBatchChunk(struct _BatchPool_ *pool)
+{
+  pthread_mutex_lock(&(pool->lock_));
+  while (pool->busy_workers_ > 0)
+  {
+    pthread_cond_wait(&(pool->work_done_), &(pool->lock_));
+  }
+  pthread_mutex_unlock(&(pool->lock_));
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Reads the next chunk of records, the payloads are copied into the 
+/// chunk as the reader buffer is reused; those of a mapped input are not
+/// 
+/// @param reader The reader to use
+/// @param chunk The chunk to fill
+/// @param[in,out] record_number The number of the last record read
+//
+void readBatchChunk(struct _RecordReader_ *reader, struct _BatchChunk_ *chunk,
+unsigned long *record_number)
+{
+  const unsigned char *record;
+  size_t record_size;
+  size_t payload_size = 0;
+  int return_value;
+
+  chunk->count_ = 0;
+  chunk->read_error_ = false;
+  while (chunk->count_ < BATCH_CHUNK_RECORDS && 
+    payload_size + QR_MAX_INPUT_SIZE <= BATCH_CHUNK_PAYLOAD_SIZE &&
+    (return_value = readRecord(reader, &record, &record_size)) != 
+    RECORD_READ_END)
+  {
+    struct _BatchRecord_ *batch_record = &(chunk->records_[chunk->count_]);
+
+    if (return_value == RECORD_READ_ERROR)
+    {
+      chunk->read_error_ = true;
       break;
-    default:
-      printf("%s", "Invalid EC Level");
-      exit(ERR_ECC_PARAMS);
+    }
+    chunk->count_++;
+    batch_record->number_ = ++(*record_number);
+    batch_record->payload_ = reader->mapping_ ? record : 
+      chunk->payloads_ + payload_size;
+    batch_record->size_ = record_size;
+    batch_record->output_size_ = 0;
+    batch_record->result_ = ERR_NO_ERROR;
+    if (return_value == RECORD_READ_TOO_LONG || 
+        record_size > QR_MAX_INPUT_SIZE)
+    {
+      batch_record->result_ = ERR_TEXT_SIZE;
+      continue;
+    }
+    if (reader->mapping_) continue;
+    memcpy(chunk->payloads_ + payload_size, record, record_size);
+    payload_size += record_size;
   }
-  return_value = generateFormatString(&format_string, flavor_to_use.version_, 
-    ec_level, MASK_PATTERN_ID);
-  checkECCReturnValue(return_value);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Writes the results of an encoded chunk in input order and empties
+/// its output arenas
+/// 
+/// @param chunk The encoded chunk
+/// @param output The stream to write to, unused in directory mode
+/// @param directory The directory the workers have written to, or NULL
+/// @param format The output format
+/// @param[in,out] result The result of the batch
+//
+void writeBatchChunk(struct _BatchChunk_ *chunk, FILE *output, 
+const char *directory, const struct _OutputFormat_ *format, int *result)
+{
+  for (size_t index = 0; index < chunk->count_; index++)
+  {
+    struct _BatchRecord_ *record = &(chunk->records_[index]);
+    const char *rendered = record->output_size_ > 0 ? 
+      chunk->arenas_[record->output_arena_].data_ + record->output_offset_ : 
+      NULL;
+
+    if (*result != ERR_IO && record->result_ == ERR_NO_ERROR && 
+        record->output_size_ > 0 && fwrite(rendered, 1, record->output_size_, 
+        output) != record->output_size_)
+    {
+      *result = ERR_IO;
+    }
 
-  mkFormatVersionPattern(matrix, size, format_string);
+    if (*result != ERR_IO && record->result_ != ERR_NO_ERROR)
+    {
+      *result = handleRecordError(record->result_, record->number_, directory,
+        format);
+    }
+  }
 
-  printf("\nMask id: %i\nFormat string: 0x%06X\n\nFinal matrix:\n", 
-    MASK_PATTERN_ID, format_string);
-  outputMatrix(matrix, size);
+  for (unsigned index = 0; index < chunk->arena_count_; index++)
+  {
+    chunk->arenas_[index].size_ = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Encodes every record of \p input. The results are either written to
+/// \p output, see writeRecord, or as one file per record into
+/// \p directory, named after the record number.
+/// 
+/// @param input The stream to read the records from
+/// @param length_prefixed Whether the records are length prefixed instead of
+/// newline terminated
+/// @param prefix The prefix of every record, or NULL
+/// @param output The stream to write to, unused if \p directory is set
+/// @param directory The directory to write to, or NULL
+/// @param format The output format
+///
+/// @return 0 on success, otherwise error code according to error codes enum
+//
+int encodeBatch(FILE *input, bool length_prefixed, const char *prefix, 
+FILE *output, const char *directory, const struct _OutputFormat_ *format)
+{
+  struct _RecordReader_ *reader;
+  struct _BatchChunk_ *chunk;
+  struct _QRCode_ *codes;
+  struct _TemplateCache_ templates;
+  unsigned long record_number = 0;
+  int result = ERR_NO_ERROR;
+
+  reader = malloc(sizeof(struct _RecordReader_));
+  chunk = malloc(sizeof(struct _BatchChunk_));
+  codes = malloc(sizeof(struct _QRCode_) * QR_MAX_BATCH_CODES);
+  if (!reader || !chunk || !codes)
+  {
+    printf("%s", "[ERR] Out of memory.\n");
+    exit(ERR_ECC_OOM);
+  }
+  openRecordReader(reader, input, length_prefixed);
+  chunk->arenas_ = NULL;
+  chunk->arena_count_ = 0;
+  initTemplateCache(&templates, prefix);
+
+  do
+  {
+    readBatchChunk(reader, chunk, &record_number);
 
-  if (write_svg) outputMatrixToSVGFile(matrix, size, filename);
-  if (write_csv) outputMatrixToCSVFile(matrix, size, filename);
+    for (size_t first = 0; first < chunk->count_ && result != ERR_IO; 
+         first += QR_MAX_BATCH_CODES)
+    {
+      const size_t count = chunk->count_ - first < QR_MAX_BATCH_CODES ? 
+        chunk->count_ - first : QR_MAX_BATCH_CODES;
 
+      encodeBatchRecords(chunk, first, count, &templates, codes);
+      for (size_t index = 0; index < count; index++)
+      {
+        struct _BatchRecord_ *record = &(chunk->records_[first + index]);
 
-  free(MessageData.data_);
-  free(message_data_stream);
-  free(ec_data);
-  for (uint8_t row = 0; row < size; row++)
+        if (record->result_ == ERR_NO_ERROR)
+        {
+          record->result_ = writeRecord(&(codes[index]), record->number_, 
+            output, directory, format);
+        }
+        if (record->result_ == ERR_NO_ERROR) continue;
+
+        result = handleRecordError(record->result_, record->number_, 
+          directory, format);
+        if (result == ERR_IO) break;
+      }
+    }
+  } while (chunk->count_ > 0 && !chunk->read_error_ && result != ERR_IO);
+
+  if (chunk->read_error_ && result != ERR_IO)
+  {
+    fprintf(stderr, "[ERR] Could not read record %lu.\n", record_number + 1);
+    result = ERR_IO;
+  }
+
+  freeTemplateCache(&templates);
+  free(codes);
+  free(chunk);
+  closeRecordReader(reader);
+  free(reader);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Encodes every record of \p input like encodeBatch, spread over
+/// \p worker_count threads. The output order matches the input order.
+/// 
+/// @param input The stream to read the records from
+/// @param length_prefixed Whether the records are length prefixed instead of
+/// newline terminated
+/// @param prefix The prefix of every record, or NULL
+/// @param output The stream to write to, unused if \p directory is set
+/// @param directory The directory to write to, or NULL
+/// @param format The output format
+/// @param worker_count The number of worker threads
+///
+/// @return 0 on success, otherwise error code according to error codes enum
+//
+int encodeBatchParallel(FILE *input, bool length_prefixed, const char *prefix,
+FILE *output, const char *directory, const struct _OutputFormat_ *format, 
+unsigned worker_count)
+{
+  struct _RecordReader_ *reader;
+  struct _BatchChunk_ *chunks[2];
+  struct _BatchPool_ pool;
+  struct _BatchWorker_ *workers;
+  unsigned long record_number = 0;
+  int result = ERR_NO_ERROR;
+  bool read_error;
+  unsigned current = 0;
+
+  reader = malloc(sizeof(struct _RecordReader_));
+  chunks[0] = malloc(sizeof(struct _BatchChunk_));
+  chunks[1] = malloc(sizeof(struct _BatchChunk_));
+  workers = malloc(sizeof(struct _BatchWorker_) * worker_count);
+  pool.queues_ = malloc(sizeof(struct _WorkQueue_) * worker_count);
+  if (!reader || !chunks[0] || !chunks[1] || !workers || !pool.queues_)
+  {
+    printf("%s", "[ERR] Out of memory.\n");
+    exit(ERR_ECC_OOM);
+  }
+  for (unsigned chunk = 0; chunk < 2; chunk++)
+  {
+    chunks[chunk]->arenas_ = malloc(sizeof(struct _OutputArena_) * 
+      worker_count);
+    chunks[chunk]->arena_count_ = worker_count;
+    if (!chunks[chunk]->arenas_)
+    {
+      printf("%s", "[ERR] Out of memory.\n");
+      exit(ERR_ECC_OOM);
+    }
+    for (unsigned index = 0; index < worker_count; index++)
+    {
+      if (!openOutputArena(&(chunks[chunk]->arenas_[index])))
+      {
+        printf("%s", "[ERR] Out of memory.\n");
+        exit(ERR_ECC_OOM);
+      }
+    }
+  }
+  openRecordReader(reader, input, length_prefixed);
+
+  pthread_mutex_init(&(pool.lock_), NULL);
+  pthread_cond_init(&(pool.work_ready_), NULL);
+  pthread_cond_init(&(pool.work_done_), NULL);
+  pool.generation_ = 0;
+  pool.busy_workers_ = 0;
+  pool.shutdown_ = false;
+  pool.chunk_ = NULL;
+  pool.worker_count_ = worker_count;
+  pool.prefix_ = prefix;
+  pool.directory_ = directory;
+  pool.format_ = format;
+  for (unsigned index = 0; index < worker_count; index++)
+  {
+    pthread_mutex_init(&(pool.queues_[index].lock_), NULL);
+    workers[index].pool_ = &pool;
+    workers[index].index_ = index;
+    if (pthread_create(&(workers[index].thread_), NULL, runBatchWorker, 
+        &(workers[index])) != 0)
+    {
+      printf("%s", "[ERR] Could not start worker thread.\n");
+      exit(ERR_ECC_OOM);
+    }
+  }
+
+  readBatchChunk(reader, chunks[current], &record_number);
+  read_error = chunks[current]->read_error_;
+  submitBatchChunk(&pool, chunks[current]);
+
+  while (chunks[current]->count_ > 0)
+  {
+    struct _BatchChunk_ *next = chunks[!current];
+
+    // read ahead while the workers encode the current chunk
+    next->count_ = 0;
+    if (!read_error && result != ERR_IO)
+    {
+      readBatchChunk(reader, next, &record_number);
+      read_error = next->read_error_;
+    }
+
+    waitForBatchChunk(&pool);
+    if (next->count_ > 0) submitBatchChunk(&pool, next);
+
+    writeBatchChunk(chunks[current], output, directory, format, &result);
+    current = !current;
+  }
+  waitForBatchChunk(&pool);
+
+  if (read_error && result != ERR_IO)
+  {
+    fprintf(stderr, "[ERR] Could not read record %lu.\n", record_number + 1);
+    result = ERR_IO;
+  }
+
+  pthread_mutex_lock(&(pool.lock_));
+  pool.shutdown_ = true;
+  pthread_cond_broadcast(&(pool.work_ready_));
+  pthread_mutex_unlock(&(pool.lock_));
+  for (unsigned index = 0; index < worker_count; index++)
+  {
+    pthread_join(workers[index].thread_, NULL);
+    pthread_mutex_destroy(&(pool.queues_[index].lock_));
+  }
+  pthread_cond_destroy(&(pool.work_done_));
+  pthread_cond_destroy(&(pool.work_ready_));
+  pthread_mutex_destroy(&(pool.lock_));
+
+  for (unsigned chunk = 0; chunk < 2; chunk++)
   {
-    free(matrix[row]);
+    for (unsigned index = 0; index < worker_count; index++)
+    {
+      closeOutputArena(&(chunks[chunk]->arenas_[index]));
+    }
+    free(chunks[chunk]->arenas_);
   }
-  free(matrix);
+  free(pool.queues_);
+  free(workers);
+  free(chunks[1]);
+  free(chunks[0]);
+  closeRecordReader(reader);
+  free(reader);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Prints the usage and exits
+//
+static inline void exitWithUsage(void)
+{
+  printf("%s", "Usage: ./ass3 [-b FILENAME | -c FILENAME] [-u] [-s] [-k]\n"
+         "       ./ass3 -i INPUT [-l] [-p PREFIX] [-f text|svg|csv|pbm|png] "
+         "[-m MODULE_SIZE] [-q QUIET_ZONE] [-o OUTPUT | -d DIRECTORY] "
+         "[-j THREADS]\n");
+  exit(ERR_PARAMS);
+}
+
+//------------------------------------------------------------------------------
+///
+/// The main program.
+/// Reads a string an generates a corresponding QR-code. With -i every record 
+/// of INPUT ("-" for stdin) is encoded, see encodeBatch; -p prepends PREFIX to
+/// every record, e.g. for serial numbers. -j spreads the records over THREADS 
+/// worker threads (0 for one per cpu), see encodeBatchParallel; build with 
+/// -pthread. The raster formats pbm and png draw every module with 
+/// MODULE_SIZE pixels and surround the symbol with QUIET_ZONE light modules.
+/// Without -i, -u shows the matrices with half-blocks, -s skips the data 
+/// matrix and -k encodes the Shift JIS characters of the text in Kanji mode.
+///
+/// @param argc The number of arguments
+/// @param argv The arguments, see exitWithUsage
+///
+/// @return 0 on success, otherwise error code according to error codes enum and
+/// the error that occured
+//
+int main(int argc, char** argv)
+{
+  unsigned char input_string[QR_MAX_INPUT_SIZE + 1];
+  uint8_t codewords[QR_MAX_CODEWORDS];
+  static uint64_t workspace[QR_MAX_WORKSPACE_SIZE / sizeof(uint64_t) + 1];
+  int input;
+  uint16_t len = 0;
+  struct _QROptions_ options = {.ec_level_ = 'L', 
+    .keep_data_matrix_ = true};
+  struct _QRCode_ code;
+  bool write_svg = false;
+  bool write_csv = false;
+  bool half_blocks = false;
+  bool skip_data_matrix = false;
+  bool kanji = false;
+  const char *filename = NULL;
+  const char *input_filename = NULL;
+  const char *output_filename = NULL;
+  const char *output_directory = NULL;
+  const char *prefix = NULL;
+  bool length_prefixed = false;
+  struct _OutputFormat_ format = {.type_ = FORMAT_TEXT, 
+    .module_size_ = RASTER_DEFAULT_MODULE_SIZE, 
+    .quiet_zone_ = RASTER_DEFAULT_QUIET_ZONE};
+  bool raster_layout = false;
+  long number;
+  long thread_count = -1;
+  char *number_end;
+
+  for (int arg = 1; arg < argc; arg++)
+  {
+    if (strcmp(argv[arg], "-l") == 0)
+    {
+      length_prefixed = true;
+      continue;
+    }
+    if (strcmp(argv[arg], "-u") == 0)
+    {
+      half_blocks = true;
+      continue;
+    }
+    if (strcmp(argv[arg], "-s") == 0)
+    {
+      skip_data_matrix = true;
+      continue;
+    }
+    if (strcmp(argv[arg], "-k") == 0)
+    {
+      kanji = true;
+      continue;
+    }
+    if (arg + 1 == argc) exitWithUsage();
+
+    if (strcmp(argv[arg], "-b") == 0)
+    {
+      write_svg = true;
+      filename = argv[++arg];
+    }
+    else if (strcmp(argv[arg], "-c") == 0)
+    {
+      write_csv = true;
+      filename = argv[++arg];
+    }
+    else if (strcmp(argv[arg], "-i") == 0) input_filename = argv[++arg];
+    else if (strcmp(argv[arg], "-o") == 0) output_filename = argv[++arg];
+    else if (strcmp(argv[arg], "-d") == 0) output_directory = argv[++arg];
+    else if (strcmp(argv[arg], "-p") == 0) prefix = argv[++arg];
+    else if (strcmp(argv[arg], "-j") == 0)
+    {
+      arg++;
+      thread_count = strtol(argv[arg], &number_end, 10);
+      if (*number_end != '\0' || thread_count < 0 || thread_count > 1024) 
+      {
+        exitWithUsage();
+      }
+      // -j 0 uses one thread per online cpu
+      if (thread_count == 0) thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+      if (thread_count < 1) thread_count = 1;
+    }
+    else if (strcmp(argv[arg], "-f") == 0)
+    {
+      arg++;
+      for (format.type_ = FORMAT_PNG; format.type_ > FORMAT_TEXT; 
+           format.type_--)
+      {
+        if (strcmp(argv[arg], FORMAT_NAMES[format.type_]) == 0) break;
+      }
+      if (strcmp(argv[arg], FORMAT_NAMES[format.type_]) != 0) exitWithUsage();
+    }
+    else if (strcmp(argv[arg], "-m") == 0)
+    {
+      arg++;
+      number = strtol(argv[arg], &number_end, 10);
+      if (*number_end != '\0' || number < 1 || 
+          number > RASTER_MAX_MODULE_SIZE) exitWithUsage();
+      format.module_size_ = number;
+      raster_layout = true;
+    }
+    else if (strcmp(argv[arg], "-q") == 0)
+    {
+      arg++;
+      number = strtol(argv[arg], &number_end, 10);
+      if (*number_end != '\0' || number < 0 || 
+          number > RASTER_MAX_QUIET_ZONE) exitWithUsage();
+      format.quiet_zone_ = number;
+      raster_layout = true;
+    }
+    else exitWithUsage();
+  }
+
+  if (input_filename)
+  {
+    FILE *input_fp = stdin;
+    FILE *output_fp = stdout;
+    int result;
+
+    if (write_svg || write_csv || half_blocks || skip_data_matrix || kanji ||
+        (output_filename && output_directory)) 
+    {
+      exitWithUsage();
+    }
+    if (strcmp(input_filename, "-") != 0) 
+    {
+      input_fp = fopen(input_filename, "rb");
+      if (!input_fp)
+      {
+        printf("[ERR] Could not read file %s.\n", input_filename);
+        exit(ERR_IO);
+      }
+    }
+    if (output_filename)
+    {
+      output_fp = fopen(output_filename, "w");
+      if (!output_fp) exitWithIOError(output_filename);
+    }
+
+    if (thread_count > 0)
+    {
+      result = encodeBatchParallel(input_fp, length_prefixed, prefix, 
+        output_fp, output_directory, &format, thread_count);
+    }
+    else
+    {
+      result = encodeBatch(input_fp, length_prefixed, prefix, output_fp, 
+        output_directory, &format);
+    }
+
+    if (input_fp != stdin) fclose(input_fp);
+    if (fflush(output_fp) == EOF) result = ERR_IO;
+    if (output_fp != stdout && fclose(output_fp) == EOF) result = ERR_IO;
+    if (result == ERR_IO && !output_directory)
+    {
+      exitWithIOError(output_filename ? output_filename : "stdout");
+    }
+    return result;
+  }
+  else if (length_prefixed || prefix || output_filename || output_directory ||
+           format.type_ != FORMAT_TEXT || raster_layout || thread_count >= 0)
+  {
+    exitWithUsage();
+  }
+
+  options.keep_data_matrix_ = !skip_data_matrix;
+  options.kanji_ = kanji;
+
+  printf("--- QR-Code Encoder ---\n\nPlease enter a text:\n");
+
+  do 
+  {
+    input = fgetc(stdin);
+    if (input == '\n' || input == EOF) break;
+    if (len == QR_MAX_INPUT_SIZE)
+    {
+      checkEncodeReturnValue(QR_ENCODE_ERROR_DATA_TOO_LONG);
+    }
+    input_string[len] = input;
+    len++;
+  }
+  while(true);
+  input_string[len] = '\0';
+
+  printf("\nMessage: %s\nLength: %i\n\n", input_string, len);
+
+  // the single QR-Code is encoded without heap memory, the static workspace 
+  // fits the largest version
+  checkEncodeReturnValue(qrEncodeInWorkspace(input_string, len, &options, 
+    workspace, qrWorkspaceSize(MAX_QR_VERSION), &code));
+
+  printf("QR-Code: %i-%c\n\n", code.version_, code.ec_level_);
+
+  printf("Message data codewords:\n");
+  outputCodewords(code.codewords_, code.data_codewords_);
+  printf("%s", "\n");
+
+  printf("Error correction codewords:\n");
+  outputCodewords(code.codewords_ + code.data_codewords_, code.ec_codewords_);
+  printf("%s", "\n");
+
+  // message, the blocks interleaved as placed into the matrix
+  interleaveCodewords(&code, codewords);
+  printf("Data codewords:\n");
+  outputCodewords(codewords, code.data_codewords_ + code.ec_codewords_);
+  printf("%s", "\n");
+
+  if (!skip_data_matrix)
+  {
+    printf("%s", "\nData matrix:\n");
+    outputMatrix(&(code.data_matrix_), half_blocks);
+  }
+
+  printf("\nMask id: %i\nFormat string: 0x%06X\n\nFinal matrix:\n", 
+    code.mask_id_, code.format_string_);
+  outputMatrix(&(code.matrix_), half_blocks);
+
+  if (write_svg) outputMatrixToSVGFile(&(code.matrix_), filename);
+  if (write_csv) outputMatrixToCSVFile(&(code.matrix_), filename);
 
   return ERR_NO_ERROR;
 }
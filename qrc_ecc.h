@@ -27,17 +27,99 @@
 #include <stdint.h>
 #include <limits.h>
 
+//------------------------------------------------------------------------------
+/// The vectorized galois field kernels are compiled for the architectures
+/// that have them and are selected at runtime; define QRC_ECC_NO_SIMD to
+/// build the scalar code only.
+//
+#if !defined(QRC_ECC_NO_SIMD) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define QRC_ECC_X86_KERNELS
+#include <immintrin.h>
+#if defined(__clang__) ? __clang_major__ >= 16 : __GNUC__ >= 11
+#define QRC_ECC_GFNI_KERNEL
+#endif
+#elif !defined(QRC_ECC_NO_SIMD) && defined(__aarch64__) && \
+    defined(__ARM_NEON)
+#define QRC_ECC_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
 #define GALOIS_FIELD_SIZE (1 << 8)
+#define GALOIS_FIELD_GENERATOR 0x11D
 
 
 //------------------------------------------------------------------------------
 ///
-/// Global variables which hold the Galois finite fields data
+/// The Galois finite fields data (log- and antilog field)
+//
+struct _Galois256Fields_
+{
+  uint8_t log_field_[GALOIS_FIELD_SIZE];
+  uint8_t exp_field_[GALOIS_FIELD_SIZE];
+};
+
+//------------------------------------------------------------------------------
 ///
-/// @note The use of any global variables is strictly forbidden in this course.
+/// The galois 256 finite fields for the field generator 285 (0x11D) which is
+/// used by the reed solomon algorithm of QR-codes. The tables are constant, so
+/// every call shares them read-only and no call has to build them.
+///
+/// @note log_field_[0] is undefined and stored as 0, like log_field_[1].
 //
-static uint8_t log_field[GALOIS_FIELD_SIZE];
-static uint8_t exp_field[GALOIS_FIELD_SIZE];
+static const struct _Galois256Fields_ GALOIS_256_FIELDS =
+{
+  .log_field_ =
+  {
+    0x00, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1A, 0xC6, 0x03, 0xDF, 0x33, 0xEE,
+    0x1B, 0x68, 0xC7, 0x4B, 0x04, 0x64, 0xE0, 0x0E, 0x34, 0x8D, 0xEF, 0x81,
+    0x1C, 0xC1, 0x69, 0xF8, 0xC8, 0x08, 0x4C, 0x71, 0x05, 0x8A, 0x65, 0x2F,
+    0xE1, 0x24, 0x0F, 0x21, 0x35, 0x93, 0x8E, 0xDA, 0xF0, 0x12, 0x82, 0x45,
+    0x1D, 0xB5, 0xC2, 0x7D, 0x6A, 0x27, 0xF9, 0xB9, 0xC9, 0x9A, 0x09, 0x78,
+    0x4D, 0xE4, 0x72, 0xA6, 0x06, 0xBF, 0x8B, 0x62, 0x66, 0xDD, 0x30, 0xFD,
+    0xE2, 0x98, 0x25, 0xB3, 0x10, 0x91, 0x22, 0x88, 0x36, 0xD0, 0x94, 0xCE,
+    0x8F, 0x96, 0xDB, 0xBD, 0xF1, 0xD2, 0x13, 0x5C, 0x83, 0x38, 0x46, 0x40,
+    0x1E, 0x42, 0xB6, 0xA3, 0xC3, 0x48, 0x7E, 0x6E, 0x6B, 0x3A, 0x28, 0x54,
+    0xFA, 0x85, 0xBA, 0x3D, 0xCA, 0x5E, 0x9B, 0x9F, 0x0A, 0x15, 0x79, 0x2B,
+    0x4E, 0xD4, 0xE5, 0xAC, 0x73, 0xF3, 0xA7, 0x57, 0x07, 0x70, 0xC0, 0xF7,
+    0x8C, 0x80, 0x63, 0x0D, 0x67, 0x4A, 0xDE, 0xED, 0x31, 0xC5, 0xFE, 0x18,
+    0xE3, 0xA5, 0x99, 0x77, 0x26, 0xB8, 0xB4, 0x7C, 0x11, 0x44, 0x92, 0xD9,
+    0x23, 0x20, 0x89, 0x2E, 0x37, 0x3F, 0xD1, 0x5B, 0x95, 0xBC, 0xCF, 0xCD,
+    0x90, 0x87, 0x97, 0xB2, 0xDC, 0xFC, 0xBE, 0x61, 0xF2, 0x56, 0xD3, 0xAB,
+    0x14, 0x2A, 0x5D, 0x9E, 0x84, 0x3C, 0x39, 0x53, 0x47, 0x6D, 0x41, 0xA2,
+    0x1F, 0x2D, 0x43, 0xD8, 0xB7, 0x7B, 0xA4, 0x76, 0xC4, 0x17, 0x49, 0xEC,
+    0x7F, 0x0C, 0x6F, 0xF6, 0x6C, 0xA1, 0x3B, 0x52, 0x29, 0x9D, 0x55, 0xAA,
+    0xFB, 0x60, 0x86, 0xB1, 0xBB, 0xCC, 0x3E, 0x5A, 0xCB, 0x59, 0x5F, 0xB0,
+    0x9C, 0xA9, 0xA0, 0x51, 0x0B, 0xF5, 0x16, 0xEB, 0x7A, 0x75, 0x2C, 0xD7,
+    0x4F, 0xAE, 0xD5, 0xE9, 0xE6, 0xE7, 0xAD, 0xE8, 0x74, 0xD6, 0xF4, 0xEA,
+    0xA8, 0x50, 0x58, 0xAF
+  },
+  .exp_field_ =
+  {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8,
+    0xCD, 0x87, 0x13, 0x26, 0x4C, 0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9,
+    0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0, 0x9D, 0x27, 0x4E, 0x9C,
+    0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23,
+    0x46, 0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2,
+    0xB9, 0x6F, 0xDE, 0xA1, 0x5F, 0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC,
+    0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0, 0xFD, 0xE7, 0xD3, 0xBB,
+    0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2,
+    0xD9, 0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68,
+    0xD0, 0xBD, 0x67, 0xCE, 0x81, 0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93,
+    0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC, 0x85, 0x17, 0x2E, 0x5C,
+    0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54,
+    0xA8, 0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72,
+    0xE4, 0xD5, 0xB7, 0x73, 0xE6, 0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E,
+    0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF, 0xE3, 0xDB, 0xAB, 0x4B,
+    0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41,
+    0x82, 0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0,
+    0xDD, 0xA7, 0x53, 0xA6, 0x51, 0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF,
+    0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09, 0x12, 0x24, 0x48, 0x90,
+    0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16,
+    0x2C, 0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8,
+    0xAD, 0x47, 0x8E, 0x01
+  }
+};
 
 //------------------------------------------------------------------------------
 /// Return constants used for all functions in this library.
@@ -73,34 +155,9 @@ enum
 #define MAX_ECC_LEN 254
 
 //------------------------------------------------------------------------------
-///
-/// This function initializes the galois 256 finite fields which are declared
-/// as global variables (log- and antilog field).
-///
-/// @param field_generator the reed solomon algorithm used in QR-codes use
-///                        the value 285 for field generation
+/// Max ecc length of a single block of any QR version
 //
-static void initializeGalois256Fields(const uint32_t field_generator)
-{
-  for(uint32_t alpha_value = 0; alpha_value < GALOIS_FIELD_SIZE; alpha_value++)
-  {
-    uint32_t integer_value = 1 << alpha_value;
-
-    if(alpha_value > 7)
-    {
-      integer_value = exp_field[alpha_value - 1] * 2;
-    }
-
-    if(integer_value > UCHAR_MAX)
-    {
-      integer_value ^= field_generator;
-    }
-
-    exp_field[alpha_value] = integer_value;
-    log_field[integer_value] = alpha_value;
-  }
-  log_field[0] = log_field[1] = 0;
-}
+#define MAX_QR_BLOCK_ECC_LEN 30
 
 //------------------------------------------------------------------------------
 ///
@@ -129,6 +186,7 @@ static uint8_t multiplyAlphaValuesByExponents(const uint8_t alpha_exponent_1,
 ///
 /// This function generates the generator polynomial for a given size
 ///
+/// @param fields the galois fields, see GALOIS_256_FIELDS
 /// @param generator_polynomial the array which stores the generator polynomial;
 ///                             must point to a valid memory with the size of
 ///                             generator_polynomial_size
@@ -139,7 +197,8 @@ static uint8_t multiplyAlphaValuesByExponents(const uint8_t alpha_exponent_1,
 ///         ERROR_CORRECTION_ERROR_INVALID_PARAMETER if this function is called
 ///         with invalid parameters
 //
-static int createGeneratorPolynomial(uint8_t *generator_polynomial,
+static int createGeneratorPolynomial(const struct _Galois256Fields_ *fields,
+                                     uint8_t *generator_polynomial,
                                      const size_t generator_polynomial_size)
 {
   if(generator_polynomial == NULL ||
@@ -169,10 +228,11 @@ static int createGeneratorPolynomial(uint8_t *generator_polynomial,
           generator_polynomial[gen_it - 1], iterator_polynomial);
 
       // add the terms by xoring them in integer notation
-      uint8_t xor_integers = exp_field[first_term] ^ exp_field[second_term];
+      uint8_t xor_integers = fields->exp_field_[first_term] ^
+                             fields->exp_field_[second_term];
 
       // convert the result back to alpha notation
-      generator_polynomial[gen_it] = log_field[xor_integers];
+      generator_polynomial[gen_it] = fields->log_field_[xor_integers];
     }
   }
 
@@ -182,78 +242,789 @@ static int createGeneratorPolynomial(uint8_t *generator_polynomial,
 
 //------------------------------------------------------------------------------
 ///
-/// This function multiplies each term in a polynomial with a given term
+/// The generator polynomials for MIN_ECC_LEN to MAX_QR_BLOCK_ECC_LEN error
+/// correction codewords, the range used by the blocks of all QR versions.
+/// They are stored in alpha notation as created by createGeneratorPolynomial,
+/// which is the form the division in generateErrorCorrectionCodewords uses.
+//
+static const uint8_t GENERATOR_POLYNOMIALS
+    [MAX_QR_BLOCK_ECC_LEN - MIN_ECC_LEN + 1][MAX_QR_BLOCK_ECC_LEN + 1] =
+{
+  // 7 codewords
+  {0, 87, 229, 146, 149, 238, 102, 21},
+  // 8 codewords
+  {0, 175, 238, 208, 249, 215, 252, 196, 28},
+  // 9 codewords
+  {0, 95, 246, 137, 231, 235, 149, 11, 123, 36},
+  // 10 codewords
+  {0, 251, 67, 46, 61, 118, 70, 64, 94, 32, 45},
+  // 11 codewords
+  {0, 220, 192, 91, 194, 172, 177, 209, 116, 227, 10, 55},
+  // 12 codewords
+  {0, 102, 43, 98, 121, 187, 113, 198, 143, 131, 87, 157, 66},
+  // 13 codewords
+  {0, 74, 152, 176, 100, 86, 100, 106, 104, 130, 218, 206, 140, 78},
+  // 14 codewords
+  {0, 199, 249, 155, 48, 190, 124, 218, 137, 216, 87, 207, 59, 22, 91},
+  // 15 codewords
+  {0, 8, 183, 61, 91, 202, 37, 51, 58, 58, 237, 140, 124, 5, 99, 105},
+  // 16 codewords
+  {0, 120, 104, 107, 109, 102, 161, 76, 3, 91, 191, 147, 169, 182, 194, 225,
+    120},
+  // 17 codewords
+  {0, 43, 139, 206, 78, 43, 239, 123, 206, 214, 147, 24, 99, 150, 39, 243, 163,
+    136},
+  // 18 codewords
+  {0, 215, 234, 158, 94, 184, 97, 118, 170, 79, 187, 152, 148, 252, 179, 5, 98,
+    96, 153},
+  // 19 codewords
+  {0, 67, 3, 105, 153, 52, 90, 83, 17, 150, 159, 44, 128, 153, 133, 252, 222,
+    138, 220, 171},
+  // 20 codewords
+  {0, 17, 60, 79, 50, 61, 163, 26, 187, 202, 180, 221, 225, 83, 239, 156, 164,
+    212, 212, 188, 190},
+  // 21 codewords
+  {0, 240, 233, 104, 247, 181, 140, 67, 98, 85, 200, 210, 115, 148, 137, 230,
+    36, 122, 254, 148, 175, 210},
+  // 22 codewords
+  {0, 210, 171, 247, 242, 93, 230, 14, 109, 221, 53, 200, 74, 8, 172, 98, 80,
+    219, 134, 160, 105, 165, 231},
+  // 23 codewords
+  {0, 171, 102, 146, 91, 49, 103, 65, 17, 193, 150, 14, 25, 183, 248, 94, 164,
+    224, 192, 1, 78, 56, 147, 253},
+  // 24 codewords
+  {0, 229, 121, 135, 48, 211, 117, 251, 126, 159, 180, 169, 152, 192, 226, 228,
+    218, 111, 0, 117, 232, 87, 96, 227, 21},
+  // 25 codewords
+  {0, 231, 181, 156, 39, 170, 26, 12, 59, 15, 148, 201, 54, 66, 237, 208, 99,
+    167, 144, 182, 95, 243, 129, 178, 252, 45},
+  // 26 codewords
+  {0, 173, 125, 158, 2, 103, 182, 118, 17, 145, 201, 111, 28, 165, 53, 161, 21,
+    245, 142, 13, 102, 48, 227, 153, 145, 218, 70},
+  // 27 codewords
+  {0, 79, 228, 8, 165, 227, 21, 180, 29, 9, 237, 70, 99, 45, 58, 138, 135, 73,
+    126, 172, 94, 216, 193, 157, 26, 17, 149, 96},
+  // 28 codewords
+  {0, 168, 223, 200, 104, 224, 234, 108, 180, 110, 190, 195, 147, 205, 27, 232,
+    201, 21, 43, 245, 87, 42, 195, 212, 119, 242, 37, 9, 123},
+  // 29 codewords
+  {0, 156, 45, 183, 29, 151, 219, 54, 96, 249, 24, 136, 5, 241, 175, 189, 28,
+    75, 234, 150, 148, 23, 9, 202, 162, 68, 250, 140, 24, 151},
+  // 30 codewords
+  {0, 41, 173, 145, 152, 216, 31, 179, 182, 50, 48, 110, 86, 239, 96, 222, 125,
+    42, 173, 226, 193, 224, 130, 156, 37, 251, 216, 238, 40, 192, 180}
+};
+
+//------------------------------------------------------------------------------
 ///
-/// @param polynomial the polynomial the term is multiplied with
-/// @param polynomial_size the size of the polynomial (# of terms)
-/// @param term the term each term in the polynomial is multiplied with
+/// This function returns the precomputed generator polynomial for a given
+/// number of error correction codewords
 ///
-/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully,
-///         ERROR_CORRECTION_ERROR_OUT_OF_MEMORY if memory allocation fails and
-///         ERROR_CORRECTION_ERROR_INVALID_PARAMETER if this function is called
-///         with invalid parameters
+/// @param number_of_error_correction_code_words the number of error
+///                                              correction codewords
+///
+/// @return the generator polynomial with
+///         number_of_error_correction_code_words + 1 terms or NULL if it is
+///         not precomputed
 //
-static int multiplyPolynomialByTerm(uint8_t *polynomial,
-                                    const size_t polynomial_size, uint8_t term)
+static const uint8_t *getGeneratorPolynomial(
+    const size_t number_of_error_correction_code_words)
 {
-  if(polynomial == NULL)
+  if(number_of_error_correction_code_words < MIN_ECC_LEN ||
+     number_of_error_correction_code_words > MAX_QR_BLOCK_ECC_LEN)
   {
-    return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
+    return NULL;
   }
 
-  // convert term to alpha notation
-  term = log_field[term];
+  return GENERATOR_POLYNOMIALS[number_of_error_correction_code_words -
+                               MIN_ECC_LEN];
+}
+
+//------------------------------------------------------------------------------
+/// Implementations of the multiply-accumulate kernel, see multiplyAddRegions
+//
+enum
+{
+  GALOIS_KERNEL_SCALAR,
+  GALOIS_KERNEL_SSSE3,
+  GALOIS_KERNEL_AVX2,
+  GALOIS_KERNEL_GFNI,
+  GALOIS_KERNEL_NEON
+};
+
+//------------------------------------------------------------------------------
+///
+/// A constant factor prepared for the multiply-accumulate kernels. A byte b is
+/// multiplied by looking up its nibbles,
+/// factor * b = low_products_[b & 0xF] ^ high_products_[b >> 4],
+/// or by the GFNI affine transformation with affine_matrix_.
+//
+struct _Galois256Multiplier_
+{
+  uint8_t low_products_[16];
+  uint8_t high_products_[16];
+  uint64_t affine_matrix_;
+};
+
+//------------------------------------------------------------------------------
+///
+/// This function multiplies a field element by alpha (x), the shift and
+/// reduction step of the field generator
+///
+/// @param value the field element in integer notation
+///
+/// @return the product in integer notation
+//
+static inline uint8_t multiplyByAlpha(const uint8_t value)
+{
+  return (uint8_t)((value << 1) ^
+                   ((value & 0x80) ? (GALOIS_FIELD_GENERATOR & 0xFF) : 0));
+}
+
+//------------------------------------------------------------------------------
+///
+/// This function prepares a constant factor for the multiply-accumulate
+/// kernels. The GFNI multiply instruction uses the AES field generator 0x11B,
+/// so the product is computed as a linear map instead: column i of the bit
+/// matrix is factor * alpha^i, byte 7 - j holds the row of output bit j.
+///
+/// @param multiplier the prepared factor
+/// @param factor the factor in integer notation
+//
+static void createGalois256Multiplier(
+    struct _Galois256Multiplier_ *multiplier, const uint8_t factor)
+{
+  uint8_t *low = multiplier->low_products_;
+  uint8_t *high = multiplier->high_products_;
 
-  // multiply the generator polynomial by the lead term of
-  // the message polynomial
-  for(size_t poly_it = 0; poly_it < polynomial_size; poly_it++)
+  uint8_t high_factor = factor;
+  for(int shift = 0; shift < 4; shift++)
   {
-    const uint8_t alpha_result = multiplyAlphaValuesByExponents(
-        polynomial[poly_it], term);
+    high_factor = multiplyByAlpha(high_factor);
+  }
 
-    // convert back to integer notation
-    polynomial[poly_it] = exp_field[alpha_result];
+  low[0] = high[0] = 0;
+  for(uint8_t nibble = 1; nibble < 16; nibble++)
+  {
+    low[nibble] = multiplyByAlpha(low[nibble >> 1]) ^
+                  ((nibble & 1) ? factor : 0);
+    high[nibble] = multiplyByAlpha(high[nibble >> 1]) ^
+                   ((nibble & 1) ? high_factor : 0);
   }
 
-  return ERROR_CORRECTION_RETURN_SUCCESSFUL;
+  // the columns factor * alpha^i are the products of the powers of two; byte
+  // i of columns holds column i, which is transposed to the rows of the matrix
+  uint64_t columns = 0;
+  for(int bit = 0; bit < 4; bit++)
+  {
+    columns |= (uint64_t)low[1 << bit] << (8 * bit);
+    columns |= (uint64_t)high[1 << bit] << (8 * (bit + 4));
+  }
+
+  uint64_t swap = (columns ^ (columns >> 7)) & 0x00AA00AA00AA00AAULL;
+  columns ^= swap ^ (swap << 7);
+  swap = (columns ^ (columns >> 14)) & 0x0000CCCC0000CCCCULL;
+  columns ^= swap ^ (swap << 14);
+  swap = (columns ^ (columns >> 28)) & 0x00000000F0F0F0F0ULL;
+  columns ^= swap ^ (swap << 28);
+
+  multiplier->affine_matrix_ = 0;
+  for(int row = 0; row < 8; row++)
+  {
+    multiplier->affine_matrix_ |=
+        ((columns >> (8 * row)) & 0xFF) << (8 * (7 - row));
+  }
 }
 
+//------------------------------------------------------------------------------
+///
+/// The portable kernel, see multiplyAddRegions
+//
+static void multiplyAddRegionsScalar(
+    uint8_t *const *destinations, const uint8_t *source, const size_t length,
+    const struct _Galois256Multiplier_ *multipliers, const size_t count)
+{
+  for(size_t region_it = 0; region_it < count; region_it++)
+  {
+    uint8_t *destination = destinations[region_it];
+    const uint8_t *low = multipliers[region_it].low_products_;
+    const uint8_t *high = multipliers[region_it].high_products_;
 
+    for(size_t position = 0; position < length; position++)
+    {
+      destination[position] ^= low[source[position] & 0x0F] ^
+                                high[source[position] >> 4];
+    }
+  }
+}
+
+#if defined(QRC_ECC_X86_KERNELS) || defined(QRC_ECC_NEON_KERNELS)
 //------------------------------------------------------------------------------
 ///
-/// This function performs an xor operation between two polynomials
+/// This function accumulates the products of the last bytes of a region that
+/// do not fill a vector, see multiplyAddRegions
+//
+static void multiplyAddTail(uint8_t *destination, const uint8_t *source,
+                            size_t position, const size_t length,
+                            const struct _Galois256Multiplier_ *multiplier)
+{
+  const uint8_t *low = multiplier->low_products_;
+  const uint8_t *high = multiplier->high_products_;
+
+  for(; position < length; position++)
+  {
+    destination[position] ^= low[source[position] & 0x0F] ^
+                             high[source[position] >> 4];
+  }
+}
+#endif
+
+#ifdef QRC_ECC_X86_KERNELS
+//------------------------------------------------------------------------------
 ///
-/// @param rem_poly the first polynomial (worker polynomial); the result of
-///                 the xor operation is stores in this array
-/// @param rem_poly_size the size of the first polynomial (# of terms)
-/// @param gen_poly the second polynomial for the xor operation
-/// @param gen_poly_size the size of the second polynomial (# of terms)
+/// The nibble-split shuffle kernel for SSSE3, see multiplyAddRegions
+//
+__attribute__((target("ssse3")))
+static void multiplyAddRegionsSSSE3(
+    uint8_t *const *destinations, const uint8_t *source, const size_t length,
+    const struct _Galois256Multiplier_ *multipliers, const size_t count)
+{
+  const __m128i nibble_mask = _mm_set1_epi8(0x0F);
+
+  for(size_t region_it = 0; region_it < count; region_it++)
+  {
+    uint8_t *destination = destinations[region_it];
+    const __m128i low_table = _mm_loadu_si128(
+        (const __m128i*)multipliers[region_it].low_products_);
+    const __m128i high_table = _mm_loadu_si128(
+        (const __m128i*)multipliers[region_it].high_products_);
+
+    size_t position = 0;
+    for(; position + 16 <= length; position += 16)
+    {
+      const __m128i data =
+          _mm_loadu_si128((const __m128i*)(source + position));
+      const __m128i low = _mm_and_si128(data, nibble_mask);
+      const __m128i high = _mm_and_si128(_mm_srli_epi64(data, 4), nibble_mask);
+      const __m128i product = _mm_xor_si128(_mm_shuffle_epi8(low_table, low),
+                                            _mm_shuffle_epi8(high_table, high));
+
+      __m128i *target = (__m128i*)(destination + position);
+      _mm_storeu_si128(target,
+                       _mm_xor_si128(_mm_loadu_si128(target), product));
+    }
+    multiplyAddTail(destination, source, position, length,
+                    &multipliers[region_it]);
+  }
+}
+
+//------------------------------------------------------------------------------
 ///
-/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully,
-///         ERROR_CORRECTION_ERROR_OUT_OF_MEMORY if memory allocation fails and
-///         ERROR_CORRECTION_ERROR_INVALID_PARAMETER if this function is called
-///         with invalid parameters
+/// The nibble-split shuffle kernel for AVX2, see multiplyAddRegions
 //
-static int xorPolynomials(uint8_t *rem_poly, const size_t rem_poly_size,
-                          uint8_t *gen_poly, const size_t gen_poly_size)
+__attribute__((target("avx2")))
+static void multiplyAddRegionsAVX2(
+    uint8_t *const *destinations, const uint8_t *source, const size_t length,
+    const struct _Galois256Multiplier_ *multipliers, const size_t count)
 {
-  if(rem_poly == NULL || gen_poly == NULL)
+  const __m256i nibble_mask = _mm256_set1_epi8(0x0F);
+
+  for(size_t region_it = 0; region_it < count; region_it++)
   {
-    return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
+    uint8_t *destination = destinations[region_it];
+    const __m256i low_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+        (const __m128i*)multipliers[region_it].low_products_));
+    const __m256i high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+        (const __m128i*)multipliers[region_it].high_products_));
+
+    size_t position = 0;
+    for(; position + 32 <= length; position += 32)
+    {
+      const __m256i data =
+          _mm256_loadu_si256((const __m256i*)(source + position));
+      const __m256i low = _mm256_and_si256(data, nibble_mask);
+      const __m256i high =
+          _mm256_and_si256(_mm256_srli_epi64(data, 4), nibble_mask);
+      const __m256i product =
+          _mm256_xor_si256(_mm256_shuffle_epi8(low_table, low),
+                           _mm256_shuffle_epi8(high_table, high));
+
+      __m256i *target = (__m256i*)(destination + position);
+      _mm256_storeu_si256(target,
+                          _mm256_xor_si256(_mm256_loadu_si256(target),
+                                           product));
+    }
+    if(position + 16 <= length)
+    {
+      const __m128i data =
+          _mm_loadu_si128((const __m128i*)(source + position));
+      const __m128i low =
+          _mm_and_si128(data, _mm256_castsi256_si128(nibble_mask));
+      const __m128i high = _mm_and_si128(_mm_srli_epi64(data, 4),
+                                         _mm256_castsi256_si128(nibble_mask));
+      const __m128i product = _mm_xor_si128(
+          _mm_shuffle_epi8(_mm256_castsi256_si128(low_table), low),
+          _mm_shuffle_epi8(_mm256_castsi256_si128(high_table), high));
+
+      __m128i *target = (__m128i*)(destination + position);
+      _mm_storeu_si128(target,
+                       _mm_xor_si128(_mm_loadu_si128(target), product));
+      position += 16;
+    }
+    multiplyAddTail(destination, source, position, length,
+                    &multipliers[region_it]);
+  }
+}
+
+#ifdef QRC_ECC_GFNI_KERNEL
+//------------------------------------------------------------------------------
+///
+/// The affine transformation kernel for GFNI with AVX2, see
+/// multiplyAddRegions
+//
+__attribute__((target("gfni,avx2")))
+static void multiplyAddRegionsGFNI(
+    uint8_t *const *destinations, const uint8_t *source, const size_t length,
+    const struct _Galois256Multiplier_ *multipliers, const size_t count)
+{
+  for(size_t region_it = 0; region_it < count; region_it++)
+  {
+    uint8_t *destination = destinations[region_it];
+    const __m256i matrix =
+        _mm256_set1_epi64x((long long)multipliers[region_it].affine_matrix_);
+
+    size_t position = 0;
+    for(; position + 32 <= length; position += 32)
+    {
+      const __m256i product = _mm256_gf2p8affine_epi64_epi8(
+          _mm256_loadu_si256((const __m256i*)(source + position)), matrix, 0);
+
+      __m256i *target = (__m256i*)(destination + position);
+      _mm256_storeu_si256(target,
+                          _mm256_xor_si256(_mm256_loadu_si256(target),
+                                           product));
+    }
+    if(position + 16 <= length)
+    {
+      const __m128i product = _mm_gf2p8affine_epi64_epi8(
+          _mm_loadu_si128((const __m128i*)(source + position)),
+          _mm256_castsi256_si128(matrix), 0);
+
+      __m128i *target = (__m128i*)(destination + position);
+      _mm_storeu_si128(target,
+                       _mm_xor_si128(_mm_loadu_si128(target), product));
+      position += 16;
+    }
+    multiplyAddTail(destination, source, position, length,
+                    &multipliers[region_it]);
   }
+}
+#endif // QRC_ECC_GFNI_KERNEL
+#endif // QRC_ECC_X86_KERNELS
 
-  // start at 1 to discard the lead 0 term
-  for(size_t rem_it = 1, gen_it = 1;
-      gen_it < gen_poly_size || rem_it < rem_poly_size; gen_it++, rem_it++)
+#ifdef QRC_ECC_NEON_KERNELS
+//------------------------------------------------------------------------------
+///
+/// The nibble-split table lookup kernel for NEON, see multiplyAddRegions
+//
+static void multiplyAddRegionsNEON(
+    uint8_t *const *destinations, const uint8_t *source, const size_t length,
+    const struct _Galois256Multiplier_ *multipliers, const size_t count)
+{
+  const uint8x16_t nibble_mask = vdupq_n_u8(0x0F);
+
+  for(size_t region_it = 0; region_it < count; region_it++)
   {
-    const uint8_t remainder = rem_it < rem_poly_size ? rem_poly[rem_it] : 0;
-    const uint8_t generator = gen_it < gen_poly_size ? gen_poly[gen_it] : 0;
+    uint8_t *destination = destinations[region_it];
+    const uint8x16_t low_table =
+        vld1q_u8(multipliers[region_it].low_products_);
+    const uint8x16_t high_table =
+        vld1q_u8(multipliers[region_it].high_products_);
+
+    size_t position = 0;
+    for(; position + 16 <= length; position += 16)
+    {
+      const uint8x16_t data = vld1q_u8(source + position);
+      const uint8x16_t product =
+          veorq_u8(vqtbl1q_u8(low_table, vandq_u8(data, nibble_mask)),
+                   vqtbl1q_u8(high_table, vshrq_n_u8(data, 4)));
+      vst1q_u8(destination + position,
+               veorq_u8(vld1q_u8(destination + position), product));
+    }
+    multiplyAddTail(destination, source, position, length,
+                    &multipliers[region_it]);
+  }
+}
+#endif // QRC_ECC_NEON_KERNELS
 
-    rem_poly[rem_it - 1] = remainder ^ generator;
+//------------------------------------------------------------------------------
+///
+/// This function selects the fastest multiply-accumulate kernel the CPU
+/// supports. It only reads the CPU features, so it is cheap enough to be
+/// called once per encoded message.
+///
+/// @return one of the GALOIS_KERNEL_* constants
+//
+static int selectGalois256Kernel(void)
+{
+#if defined(QRC_ECC_X86_KERNELS)
+#ifdef QRC_ECC_GFNI_KERNEL
+  if(__builtin_cpu_supports("gfni") && __builtin_cpu_supports("avx2"))
+  {
+    return GALOIS_KERNEL_GFNI;
+  }
+#endif
+  if(__builtin_cpu_supports("avx2"))
+  {
+    return GALOIS_KERNEL_AVX2;
   }
-  rem_poly[rem_poly_size - 1] = 0;
+  if(__builtin_cpu_supports("ssse3"))
+  {
+    return GALOIS_KERNEL_SSSE3;
+  }
+#elif defined(QRC_ECC_NEON_KERNELS)
+  return GALOIS_KERNEL_NEON;
+#endif
+  return GALOIS_KERNEL_SCALAR;
+}
 
-  return ERROR_CORRECTION_RETURN_SUCCESSFUL;
+//------------------------------------------------------------------------------
+///
+/// This function multiplies a region by several constants and adds (xors)
+/// each product to its own region:
+/// destinations[r][i] ^= factor_r * source[i] for r < count
+///
+/// @param kernel the kernel to use, see selectGalois256Kernel
+/// @param destinations the regions the products are added to
+/// @param source the region that is multiplied, in integer notation
+/// @param length the size of all regions
+/// @param multipliers the constants, see createGalois256Multiplier
+/// @param count the number of destination regions and constants
+//
+static void multiplyAddRegions(const int kernel, uint8_t *const *destinations,
+                               const uint8_t *source, const size_t length,
+                               const struct _Galois256Multiplier_ *multipliers,
+                               const size_t count)
+{
+  switch(kernel)
+  {
+#ifdef QRC_ECC_X86_KERNELS
+    case GALOIS_KERNEL_SSSE3:
+      multiplyAddRegionsSSSE3(destinations, source, length, multipliers,
+                              count);
+      return;
+    case GALOIS_KERNEL_AVX2:
+      multiplyAddRegionsAVX2(destinations, source, length, multipliers, count);
+      return;
+#ifdef QRC_ECC_GFNI_KERNEL
+    case GALOIS_KERNEL_GFNI:
+      multiplyAddRegionsGFNI(destinations, source, length, multipliers, count);
+      return;
+#endif
+#endif
+#ifdef QRC_ECC_NEON_KERNELS
+    case GALOIS_KERNEL_NEON:
+      multiplyAddRegionsNEON(destinations, source, length, multipliers, count);
+      return;
+#endif
+    default:
+      multiplyAddRegionsScalar(destinations, source, length, multipliers,
+                               count);
+      return;
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// This function multiplies a region by a constant and adds (xors) the
+/// products to another region: destination[i] ^= factor * source[i]
+///
+/// @param kernel the kernel to use, see selectGalois256Kernel
+/// @param destination the region the products are added to
+/// @param source the region that is multiplied, in integer notation
+/// @param length the size of both regions
+/// @param multiplier the constant, see createGalois256Multiplier
+//
+static void multiplyAddRegion(const int kernel, uint8_t *destination,
+                              const uint8_t *source, const size_t length,
+                              const struct _Galois256Multiplier_ *multiplier)
+{
+  multiplyAddRegions(kernel, &destination, source, length, multiplier, 1);
+}
+
+//------------------------------------------------------------------------------
+///
+/// The products of a generator polynomial with every nibble value, used by the
+/// shift register: the generator times a feedback term f is
+/// low_[f & 0xF] ^ high_[f >> 4]. Only the terms after the lead term (alpha^0)
+/// are stored, in integer notation. The rows are padded with 0 terms to whole
+/// 64 bit words, see getParityRegisterSize.
+//
+#define PARITY_REGISTER_SIZE (MAX_ECC_LEN + 2)
+
+struct _GeneratorProducts_
+{
+  uint8_t low_[16][PARITY_REGISTER_SIZE];
+  uint8_t high_[16][PARITY_REGISTER_SIZE];
+};
+
+//------------------------------------------------------------------------------
+///
+/// This function rounds a number of error correction codewords up to the
+/// whole 64 bit words the shift register is processed in
+///
+/// @param size the number of error correction codewords
+///
+/// @return the padded size
+//
+static inline size_t getParityRegisterSize(const size_t size)
+{
+  return (size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+}
+
+//------------------------------------------------------------------------------
+///
+/// This function adds (xors) two regions of whole 64 bit words
+///
+/// @param destination the sum
+/// @param first the first region
+/// @param second the second region
+/// @param size the size of the regions, a multiple of 8
+//
+static void addRegions(uint8_t *destination, const uint8_t *first,
+                       const uint8_t *second, const size_t size)
+{
+  for(size_t word_it = 0; word_it < size; word_it += sizeof(uint64_t))
+  {
+    uint64_t first_word, second_word;
+    memcpy(&first_word, first + word_it, sizeof(uint64_t));
+    memcpy(&second_word, second + word_it, sizeof(uint64_t));
+
+    first_word ^= second_word;
+    memcpy(destination + word_it, &first_word, sizeof(uint64_t));
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// This function multiplies a polynomial with every nibble value: row n of
+/// low_rows is n * p and row n of high_rows is (n << 4) * p. The products of
+/// the powers of two are multiplied by alpha from each other, all others are
+/// sums of them: n * p = 2^b * p + (n - 2^b) * p.
+///
+/// @param kernel the kernel to use, see selectGalois256Kernel
+/// @param low_rows the products with the low nibble values
+/// @param high_rows the products with the high nibble values
+/// @param row_stride the distance of two rows, at least
+///                   getParityRegisterSize(size)
+/// @param polynomial the polynomial in integer notation
+/// @param size the number of terms of the polynomial
+//
+static void createNibbleProducts(const int kernel, uint8_t *low_rows,
+                                 uint8_t *high_rows, const size_t row_stride,
+                                 const uint8_t *polynomial, const size_t size)
+{
+  const size_t row_size = getParityRegisterSize(size);
+  struct _Galois256Multiplier_ alpha;
+  struct _Galois256Multiplier_ alpha_4;
+  createGalois256Multiplier(&alpha, 0x02);
+  createGalois256Multiplier(&alpha_4, 0x10);
+
+  memset(low_rows, 0, 2 * row_stride);
+  memset(high_rows, 0, 2 * row_stride);
+  memcpy(low_rows + row_stride, polynomial, size);
+  multiplyAddRegion(kernel, high_rows + row_stride, low_rows + row_stride,
+                    row_size, &alpha_4);
+
+  for(size_t power = 2; power < 16; power <<= 1)
+  {
+    uint8_t *low = low_rows + power * row_stride;
+    uint8_t *high = high_rows + power * row_stride;
+
+    memset(low, 0, row_size);
+    multiplyAddRegion(kernel, low, low_rows + (power >> 1) * row_stride,
+                      row_size, &alpha);
+
+    memset(high, 0, row_size);
+    multiplyAddRegion(kernel, high, high_rows + (power >> 1) * row_stride,
+                      row_size, &alpha);
+
+    for(size_t nibble = power + 1; nibble < 2 * power; nibble++)
+    {
+      addRegions(low_rows + nibble * row_stride, low,
+                 low_rows + (nibble - power) * row_stride, row_size);
+      addRegions(high_rows + nibble * row_stride, high,
+                 high_rows + (nibble - power) * row_stride, row_size);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// This function multiplies a generator polynomial with every nibble value,
+/// see createNibbleProducts
+///
+/// @param kernel the kernel to use, see selectGalois256Kernel
+/// @param products the result parameter
+/// @param generator_polynomial the generator polynomial in alpha notation
+/// @param size the number of terms after the lead term
+//
+static void createGeneratorProducts(const int kernel,
+                                    struct _GeneratorProducts_ *products,
+                                    const uint8_t *generator_polynomial,
+                                    const size_t size)
+{
+  uint8_t generator_terms[MAX_ECC_LEN];
+  for(size_t term_it = 0; term_it < size; term_it++)
+  {
+    generator_terms[term_it] =
+        GALOIS_256_FIELDS.exp_field_[generator_polynomial[term_it + 1]];
+  }
+
+  createNibbleProducts(kernel, (uint8_t *)products->low_,
+                       (uint8_t *)products->high_,
+                       PARITY_REGISTER_SIZE, generator_terms, size);
+}
+
+//------------------------------------------------------------------------------
+///
+/// Min message length times ecc length from which creating the generator
+/// products pays off; shorter messages are clocked with table lookups
+//
+#define MIN_GENERATOR_PRODUCTS_WORK 384
+
+//------------------------------------------------------------------------------
+///
+/// This function clocks one message codeword through the shift register of
+/// the reed solomon encoder. The register holds the running remainder of the
+/// division by the generator polynomial; the codeword is added to its lead
+/// term, the register is shifted by one term and the generator polynomial
+/// times the feedback term is added to it.
+///
+/// @param fields the galois fields, see GALOIS_256_FIELDS
+/// @param parity the shift register (remainder) with parity_size terms
+/// @param parity_size the number of error correction codewords
+/// @param generator_polynomial the generator polynomial in alpha notation with
+///                             parity_size + 1 terms
+/// @param code_word the message codeword clocked into the register
+//
+static void clockParityRegister(const struct _Galois256Fields_ *fields,
+                                uint8_t *parity, const size_t parity_size,
+                                const uint8_t *generator_polynomial,
+                                const uint8_t code_word)
+{
+  const uint8_t feedback = code_word ^ parity[0];
+
+  if(feedback == 0)
+  {
+    memmove(parity, parity + 1, parity_size - 1);
+    parity[parity_size - 1] = 0;
+    return;
+  }
+
+  // the lead term of the generator is alpha^0, so it always cancels the
+  // feedback and is skipped
+  const uint8_t feedback_alpha = fields->log_field_[feedback];
+  for(size_t parity_it = 0; parity_it < parity_size - 1; parity_it++)
+  {
+    parity[parity_it] = parity[parity_it + 1] ^
+        fields->exp_field_[multiplyAlphaValuesByExponents(
+            generator_polynomial[parity_it + 1], feedback_alpha)];
+  }
+  parity[parity_size - 1] = fields->exp_field_[multiplyAlphaValuesByExponents(
+      generator_polynomial[parity_size], feedback_alpha)];
+}
+
+//------------------------------------------------------------------------------
+///
+/// This function clocks one message codeword through the shift register like
+/// clockParityRegister, with the products of the generator polynomial
+/// instead of table lookups. The register is processed in 64
+/// bit words; its padding terms stay 0 because the padding of the products
+/// is 0.
+///
+/// @param parity the shift register (remainder), with one more word than
+///               parity_size terms
+/// @param parity_size the number of error correction codewords
+/// @param low_rows the products of the generator polynomial with the low
+///                 nibble values, see createNibbleProducts
+/// @param high_rows the products with the high nibble values
+/// @param row_stride the distance of two rows
+/// @param code_word the message codeword clocked into the register
+//
+static void clockParityRegisterByRows(
+    uint8_t *parity, const size_t parity_size, const uint8_t *low_rows,
+    const uint8_t *high_rows, const size_t row_stride, const uint8_t code_word)
+{
+  const uint8_t feedback = code_word ^ parity[0];
+  const uint8_t *low = low_rows + (feedback & 0x0F) * row_stride;
+  const uint8_t *high = high_rows + (feedback >> 4) * row_stride;
+
+  for(size_t word_it = 0; word_it < parity_size; word_it += sizeof(uint64_t))
+  {
+    uint64_t shifted, low_word, high_word;
+    memcpy(&shifted, parity + word_it + 1, sizeof(uint64_t));
+    memcpy(&low_word, low + word_it, sizeof(uint64_t));
+    memcpy(&high_word, high + word_it, sizeof(uint64_t));
+
+    shifted ^= low_word ^ high_word;
+    memcpy(parity + word_it, &shifted, sizeof(uint64_t));
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// This function clocks one message codeword through the shift register with
+/// the generator products, see clockParityRegisterByRows
+///
+/// @param parity the shift register (remainder), with one more word than
+///               parity_size terms
+/// @param parity_size the number of error correction codewords
+/// @param products the products of the generator polynomial
+/// @param code_word the message codeword clocked into the register
+//
+static inline void clockParityRegisterByProducts(
+    uint8_t *parity, const size_t parity_size,
+    const struct _GeneratorProducts_ *products, const uint8_t code_word)
+{
+  clockParityRegisterByRows(parity, parity_size, products->low_[0],
+                            products->high_[0], PARITY_REGISTER_SIZE,
+                            code_word);
+}
+
+//------------------------------------------------------------------------------
+///
+/// This function returns the generator polynomial for a number of error
+/// correction codewords. The ones of QR-Codes are precomputed, others are
+/// created.
+///
+/// @param created_generator_polynomial storage for a created polynomial with
+///                                     number_of_error_correction_code_words
+///                                     + 1 terms
+/// @param number_of_error_correction_code_words the degree of the polynomial
+///
+/// @return the generator polynomial in alpha notation or NULL if it can not
+///         be created
+//
+static const uint8_t *loadGeneratorPolynomial(
+    uint8_t *created_generator_polynomial,
+    const size_t number_of_error_correction_code_words)
+{
+  const uint8_t *generator_polynomial =
+      getGeneratorPolynomial(number_of_error_correction_code_words);
+  if(generator_polynomial != NULL)
+  {
+    return generator_polynomial;
+  }
+
+  if(createGeneratorPolynomial(&GALOIS_256_FIELDS,
+                               created_generator_polynomial,
+                               number_of_error_correction_code_words + 1) !=
+     ERROR_CORRECTION_RETURN_SUCCESSFUL)
+  {
+    return NULL;
+  }
+  return created_generator_polynomial;
 }
 
 //------------------------------------------------------------------------------
@@ -263,6 +1034,8 @@ static int xorPolynomials(uint8_t *rem_poly, const size_t rem_poly_size,
 ///          codewords for a given message. The message must include
 ///          mode indicator, character count indicator, text data with
 ///          terminator and 0xEC11 padding.
+///          The message is divided by the generator polynomial with a linear
+///          shift register, so no memory is allocated.
 ///
 /// @param error_correction_code_words the result parameter; it must be a
 ///                                    preallocated array with the size of
@@ -274,8 +1047,7 @@ static int xorPolynomials(uint8_t *rem_poly, const size_t rem_poly_size,
 ///                calculated for
 /// @param message_length the size of the message
 ///
-/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully,
-///         ERROR_CORRECTION_ERROR_OUT_OF_MEMORY if memory allocation fails and
+/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully and
 ///         ERROR_CORRECTION_ERROR_INVALID_PARAMETER if this function is called
 ///         with invalid parameters
 //
@@ -284,160 +1056,559 @@ static int generateErrorCorrectionCodewords(
     const size_t number_of_error_correction_code_words,
     const uint8_t *message, const size_t message_length)
 {
-  int ret = ERROR_CORRECTION_RETURN_SUCCESSFUL;
-
   if(error_correction_code_words == NULL ||
+     (message == NULL && message_length > 0) ||
      number_of_error_correction_code_words < MIN_ECC_LEN ||
      number_of_error_correction_code_words > MAX_ECC_LEN)
   {
     return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
   }
 
-  initializeGalois256Fields(0x11D);
+  uint8_t created_generator_polynomial[MAX_ECC_LEN + 1];
+  const uint8_t *generator_polynomial = loadGeneratorPolynomial(
+      created_generator_polynomial, number_of_error_correction_code_words);
+  if(generator_polynomial == NULL)
+  {
+    return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
+  }
 
   // ---------------------------------------------------------------------------
-  const size_t generator_polynomial_size =
-      number_of_error_correction_code_words + 1;
+  // divide the message polynomial by the generator polynomial; the remainder
+  // left in the register is used for the error correction codewords
+  if(message_length * number_of_error_correction_code_words <
+     MIN_GENERATOR_PRODUCTS_WORK)
+  {
+    memset(error_correction_code_words, 0,
+           number_of_error_correction_code_words);
+
+    for(size_t message_it = 0; message_it < message_length; message_it++)
+    {
+      clockParityRegister(&GALOIS_256_FIELDS, error_correction_code_words,
+                          number_of_error_correction_code_words,
+                          generator_polynomial, message[message_it]);
+    }
+    return ERROR_CORRECTION_RETURN_SUCCESSFUL;
+  }
+
+  struct _GeneratorProducts_ products;
+  createGeneratorProducts(selectGalois256Kernel(), &products,
+                          generator_polynomial,
+                          number_of_error_correction_code_words);
+
+  uint8_t parity[PARITY_REGISTER_SIZE + sizeof(uint64_t)] = {0};
+
+  for(size_t message_it = 0; message_it < message_length; message_it++)
+  {
+    clockParityRegisterByProducts(parity,
+                                  number_of_error_correction_code_words,
+                                  &products, message[message_it]);
+  }
+
+  memcpy(error_correction_code_words, parity,
+         number_of_error_correction_code_words);
+
+  return ERROR_CORRECTION_RETURN_SUCCESSFUL;
+}
+
+//------------------------------------------------------------------------------
+///
+/// Size of the workspace of generateErrorCorrectionCodewordsInWorkspace for n
+/// error correction codewords: 32 nibble product rows and the shift register,
+/// all padded to whole 64 bit words, and the generator polynomial
+//
+#define ERROR_CORRECTION_WORKSPACE_SIZE(n) \
+  (33 * (((n) + 7) / 8 * 8) + sizeof(uint64_t) + (n) + 1)
+
+//------------------------------------------------------------------------------
+///
+/// @brief Prepares a workspace for generateErrorCorrectionCodewordsInWorkspace
+/// @details The generator products are created once and stored in the
+///          workspace, so all messages with the same number of error
+///          correction codewords share them.
+///
+/// @param number_of_error_correction_code_words the number of error
+///                                              correction codewords
+/// @param workspace a buffer of ERROR_CORRECTION_WORKSPACE_SIZE(
+///                  number_of_error_correction_code_words) bytes
+///
+/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully and
+///         ERROR_CORRECTION_ERROR_INVALID_PARAMETER if this function is called
+///         with invalid parameters
+//
+static int prepareErrorCorrectionWorkspace(
+    const size_t number_of_error_correction_code_words, uint8_t *workspace)
+{
+  const size_t parity_size = number_of_error_correction_code_words;
+
+  if(workspace == NULL ||
+     parity_size < MIN_ECC_LEN || parity_size > MAX_ECC_LEN)
+  {
+    return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
+  }
+
+  const size_t row_size = getParityRegisterSize(parity_size);
+  uint8_t *low_rows = workspace;
+  uint8_t *high_rows = low_rows + 16 * row_size;
+  uint8_t *parity = high_rows + 16 * row_size;
 
-  uint8_t *generator_polynomial = (uint8_t*)malloc(generator_polynomial_size);
+  const uint8_t *generator_polynomial = loadGeneratorPolynomial(
+      parity + row_size + sizeof(uint64_t), parity_size);
   if(generator_polynomial == NULL)
   {
-    return ERROR_CORRECTION_ERROR_OUT_OF_MEMORY;
+    return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
   }
 
-  ret = createGeneratorPolynomial(generator_polynomial,
-      generator_polynomial_size);
+  // the lead term of the generator is alpha^0 and is skipped; the other terms
+  // are converted to integers in the register, which is cleared per message
+  for(size_t term_it = 0; term_it < parity_size; term_it++)
+  {
+    parity[term_it] =
+        GALOIS_256_FIELDS.exp_field_[generator_polynomial[term_it + 1]];
+  }
+  createNibbleProducts(selectGalois256Kernel(), low_rows, high_rows, row_size,
+                       parity, parity_size);
+
+  return ERROR_CORRECTION_RETURN_SUCCESSFUL;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Creates the error correction codewords like
+///        generateErrorCorrectionCodewords, within a workspace.
+/// @details The workspace holds the generator products of
+///          prepareErrorCorrectionWorkspace and the shift register, so the
+///          stack usage is small and fixed. Every message codeword is clocked
+///          with the products, the time only depends on the sizes.
+///
+/// @param error_correction_code_words the result parameter; it must be a
+///                                    preallocated array with the size of
+///                                    number_of_error_correction_code_words
+/// @param number_of_error_correction_code_words the size of the
+///                                              error_correction_code_words
+///                                              parameter, the same as for
+///                                              the prepared workspace
+/// @param message the message the error correction words should be
+///                calculated for
+/// @param message_length the size of the message
+/// @param workspace a workspace prepared by prepareErrorCorrectionWorkspace
+///
+/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully and
+///         ERROR_CORRECTION_ERROR_INVALID_PARAMETER if this function is called
+///         with invalid parameters
+//
+static int generateErrorCorrectionCodewordsInWorkspace(
+    uint8_t *error_correction_code_words,
+    const size_t number_of_error_correction_code_words,
+    const uint8_t *message, const size_t message_length,
+    uint8_t *workspace)
+{
+  const size_t parity_size = number_of_error_correction_code_words;
 
-  if(ret != ERROR_CORRECTION_RETURN_SUCCESSFUL)
+  if(error_correction_code_words == NULL || workspace == NULL ||
+     (message == NULL && message_length > 0) ||
+     parity_size < MIN_ECC_LEN || parity_size > MAX_ECC_LEN)
   {
-    free(generator_polynomial);
-    return ret;
+    return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
   }
 
-  // ---------------------------------------------------------------------------
-  size_t remainder_polynomial_size =
-      generator_polynomial_size > message_length ? generator_polynomial_size :
-                                                   message_length;
+  const size_t row_size = getParityRegisterSize(parity_size);
+  const uint8_t *low_rows = workspace;
+  const uint8_t *high_rows = low_rows + 16 * row_size;
+  uint8_t *parity = workspace + 32 * row_size;
 
-  uint8_t *remainder_polynomial =
-      (uint8_t*)calloc(sizeof(uint8_t), remainder_polynomial_size);
-  if(remainder_polynomial == NULL)
+  memset(parity, 0, row_size + sizeof(uint64_t));
+
+  for(size_t message_it = 0; message_it < message_length; message_it++)
   {
-    free(generator_polynomial);
-    return ERROR_CORRECTION_ERROR_OUT_OF_MEMORY;
+    clockParityRegisterByRows(parity, parity_size, low_rows, high_rows,
+                              row_size, message[message_it]);
+  }
+
+  memcpy(error_correction_code_words, parity, parity_size);
+
+  return ERROR_CORRECTION_RETURN_SUCCESSFUL;
+}
+
+//------------------------------------------------------------------------------
+///
+/// A template message whose codewords from first_variable_ on change between
+/// encodings, e.g. a serial number after a fixed prefix. Reed solomon codes
+/// are linear, so the error correction codewords of a changed message are the
+/// ones of the template plus the ones of the difference; the difference of
+/// codeword i contributes diff * R_i, where R_i is the remainder of x^(n-1-i).
+/// The products of each R_i with all nibble values are stored, so a changed
+/// codeword costs two row additions, see createNibbleProducts.
+//
+struct _ECCTemplate_
+{
+  size_t parity_size_;
+  size_t row_size_;
+  size_t message_length_;
+  size_t first_variable_;
+  size_t variable_count_;
+  // the error correction codewords of the template, padded to row_size_
+  uint8_t *parity_;
+  // the variable codewords of the template
+  uint8_t *variable_code_words_;
+  // 16 low and 16 high nibble products of R_i per variable codeword
+  uint8_t *products_;
+};
+
+//------------------------------------------------------------------------------
+///
+/// @brief Creates a template for generateTemplateErrorCorrectionCodewords.
+/// @details The error correction codewords of the template message are
+///          created once, as well as the contribution of every variable
+///          codeword. The remainders R_i are found by clocking one 1 and then
+///          zeros through the shift register, from the last codeword of the
+///          message backwards. The template must be freed with
+///          freeECCTemplate.
+///
+/// @param ecc_template the result parameter
+/// @param number_of_error_correction_code_words the number of error correction
+///                                              codewords
+/// @param message the template message, see generateErrorCorrectionCodewords
+/// @param message_length the size of the message
+/// @param first_variable the index of the first codeword that may change
+/// @param variable_count the number of codewords that may change
+///
+/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully,
+///         ERROR_CORRECTION_ERROR_OUT_OF_MEMORY if the template can not be
+///         allocated and ERROR_CORRECTION_ERROR_INVALID_PARAMETER if this
+///         function is called with invalid parameters
+//
+static int createECCTemplate(struct _ECCTemplate_ *ecc_template,
+                             const size_t number_of_error_correction_code_words,
+                             const uint8_t *message,
+                             const size_t message_length,
+                             const size_t first_variable,
+                             const size_t variable_count)
+{
+  const size_t parity_size = number_of_error_correction_code_words;
+
+  if(ecc_template == NULL || message == NULL ||
+     first_variable > message_length ||
+     variable_count > message_length - first_variable ||
+     parity_size < MIN_ECC_LEN || parity_size > MAX_ECC_LEN)
+  {
+    return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
+  }
+
+  const size_t row_size = getParityRegisterSize(parity_size);
+
+  uint8_t created_generator_polynomial[MAX_ECC_LEN + 1];
+  const uint8_t *generator_polynomial =
+      loadGeneratorPolynomial(created_generator_polynomial, parity_size);
+  if(generator_polynomial == NULL)
+  {
+    return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
   }
-  memcpy(remainder_polynomial, message, message_length);
 
   // ---------------------------------------------------------------------------
-  uint8_t *generator_polynomial_times_lead_term =
-      (uint8_t*)malloc(generator_polynomial_size);
-  if(generator_polynomial_times_lead_term == NULL)
+  // the parity, the variable codewords and the products in one allocation
+  uint8_t *memory = malloc(row_size + variable_count +
+                           variable_count * 32 * row_size);
+  if(memory == NULL)
   {
-    free(remainder_polynomial);
-    free(generator_polynomial);
     return ERROR_CORRECTION_ERROR_OUT_OF_MEMORY;
   }
 
+  // the parity of the template message
+  memset(memory, 0, row_size);
+  const int return_value = generateErrorCorrectionCodewords(
+      memory, parity_size, message, message_length);
+  if(return_value != ERROR_CORRECTION_RETURN_SUCCESSFUL)
+  {
+    free(memory);
+    return return_value;
+  }
+
+  ecc_template->parity_size_ = parity_size;
+  ecc_template->row_size_ = row_size;
+  ecc_template->message_length_ = message_length;
+  ecc_template->first_variable_ = first_variable;
+  ecc_template->variable_count_ = variable_count;
+  ecc_template->parity_ = memory;
+  ecc_template->products_ = memory + row_size;
+  ecc_template->variable_code_words_ =
+      ecc_template->products_ + variable_count * 32 * row_size;
+
+  memcpy(ecc_template->variable_code_words_, message + first_variable,
+         variable_count);
+  if(variable_count == 0)
+  {
+    return ERROR_CORRECTION_RETURN_SUCCESSFUL;
+  }
+
   // ---------------------------------------------------------------------------
-  // divide the message polynomial by the generator polynomial
-  for(size_t division_step = 0; division_step < message_length; division_step++)
+  // clock 1 for the last codeword and 0 for every codeword before it
+  const int kernel = selectGalois256Kernel();
+  struct _GeneratorProducts_ products;
+  createGeneratorProducts(kernel, &products, generator_polynomial,
+                          parity_size);
+
+  uint8_t remainder[PARITY_REGISTER_SIZE + sizeof(uint64_t)] = {0};
+  uint8_t code_word = 1;
+
+  for(size_t message_it = message_length; message_it-- > first_variable;)
   {
-    // multiply the generator polynomial by the lead term
-    // of the message polynomial
-    memcpy(generator_polynomial_times_lead_term,
-           generator_polynomial, generator_polynomial_size);
+    clockParityRegisterByProducts(remainder, parity_size, &products,
+                                  code_word);
+    code_word = 0;
 
-    ret = multiplyPolynomialByTerm(generator_polynomial_times_lead_term,
-        generator_polynomial_size, remainder_polynomial[0]);
-    if(ret != ERROR_CORRECTION_RETURN_SUCCESSFUL)
+    if(message_it < first_variable + variable_count)
     {
-      free(generator_polynomial_times_lead_term);
-      free(remainder_polynomial);
-      free(generator_polynomial);
-      return ret;
+      uint8_t *rows = ecc_template->products_ +
+          (message_it - first_variable) * 32 * row_size;
+      createNibbleProducts(kernel, rows, rows + 16 * row_size, row_size,
+                           remainder, parity_size);
     }
+  }
 
-    // XOR the result with the message polynomial
-    ret = xorPolynomials(remainder_polynomial, remainder_polynomial_size,
-                   generator_polynomial_times_lead_term,
-                   generator_polynomial_size);
-    if(ret != ERROR_CORRECTION_RETURN_SUCCESSFUL)
-    {
-      free(generator_polynomial_times_lead_term);
-      free(remainder_polynomial);
-      free(generator_polynomial);
-      return ret;
-    }
+  return ERROR_CORRECTION_RETURN_SUCCESSFUL;
+}
 
-    // discard leading 0 terms
-    for(size_t discard_it = remainder_polynomial_size;
-        discard_it-- > 0 && remainder_polynomial[0] == 0;)
+//------------------------------------------------------------------------------
+///
+/// This function frees the memory of a template created by createECCTemplate
+///
+/// @param ecc_template the template
+//
+static void freeECCTemplate(struct _ECCTemplate_ *ecc_template)
+{
+  if(ecc_template != NULL)
+  {
+    free(ecc_template->parity_);
+    ecc_template->parity_ = NULL;
+    ecc_template->products_ = NULL;
+    ecc_template->variable_code_words_ = NULL;
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Creates the error correction codewords of a message that differs
+///        from the template message only in the variable codewords.
+/// @details The contribution of every changed codeword is added to the error
+///          correction codewords of the template, see _ECCTemplate_.
+///
+/// @param ecc_template the template, see createECCTemplate
+/// @param error_correction_code_words the result parameter; it must be a
+///                                    preallocated array with the size of
+///                                    the template's error correction codewords
+/// @param message the message with the length of the template message
+///
+/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully and
+///         ERROR_CORRECTION_ERROR_INVALID_PARAMETER if this function is called
+///         with invalid parameters
+//
+static int generateTemplateErrorCorrectionCodewords(
+    const struct _ECCTemplate_ *ecc_template,
+    uint8_t *error_correction_code_words, const uint8_t *message)
+{
+  if(ecc_template == NULL || ecc_template->parity_ == NULL ||
+     error_correction_code_words == NULL || message == NULL)
+  {
+    return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
+  }
+
+  const size_t row_size = ecc_template->row_size_;
+  const uint8_t *variable_code_words = message + ecc_template->first_variable_;
+
+  uint8_t parity[PARITY_REGISTER_SIZE];
+  memcpy(parity, ecc_template->parity_, row_size);
+
+  for(size_t variable_it = 0; variable_it < ecc_template->variable_count_;
+      variable_it++)
+  {
+    const uint8_t difference = variable_code_words[variable_it] ^
+        ecc_template->variable_code_words_[variable_it];
+    if(difference == 0)
     {
-      for(size_t rem_it = 0; rem_it < remainder_polynomial_size - 1; rem_it++)
-      {
-        remainder_polynomial[rem_it] = remainder_polynomial[rem_it + 1];
-      }
-      remainder_polynomial[remainder_polynomial_size - 1] = 0;
-      division_step++;
+      continue;
     }
+
+    const uint8_t *rows = ecc_template->products_ +
+        variable_it * 32 * row_size;
+    addRegions(parity, parity, rows + (difference & 0x0F) * row_size,
+               row_size);
+    addRegions(parity, parity, rows + (16 + (difference >> 4)) * row_size,
+               row_size);
   }
 
-  // the remainder polynomial is used for the error correction codewords
-  memcpy(error_correction_code_words, remainder_polynomial,
-         number_of_error_correction_code_words);
+  memcpy(error_correction_code_words, parity, ecc_template->parity_size_);
 
-  free(generator_polynomial_times_lead_term);
-  free(remainder_polynomial);
-  free(generator_polynomial);
-  return ret;
+  return ERROR_CORRECTION_RETURN_SUCCESSFUL;
 }
 
+//------------------------------------------------------------------------------
+/// Max number of messages generateErrorCorrectionCodewordsBatch clocks through
+/// its shift registers at once
+//
+#define MAX_ECC_BATCH_SIZE 64
+
+//------------------------------------------------------------------------------
+/// Number of lanes generateErrorCorrectionCodewordsBatch rounds up to, so the
+/// kernels do not fall back to their scalar tail
+//
+#define MIN_ECC_BATCH_REGION 16
 
 //------------------------------------------------------------------------------
 ///
-/// This function performs a polynomial division with two binary polynomials
+/// @brief Creates the error correction codewords of several messages of the
+///        same length, see generateErrorCorrectionCodewords.
+/// @details The messages and codewords are stored as structure of arrays:
+///          codeword i of message m is at index i * number_of_messages + m.
+///          Every message is a byte lane of the shift registers, so each
+///          clock is one multiply-accumulate of the feedback of all lanes
+///          per generator term. The multipliers of the generator terms are
+///          prepared once for all messages.
 ///
-/// @param format_string the pointer to the current format string
-/// @param format_string_size the pointer to the size of the format string
-///                           in bits
-/// @param generator_polynomial the generator polynomial
-/// @param generator_polynomial_size the size of the generator polynomial
-///                                  (# of bits)
+/// @param error_correction_code_words the result parameter; it must be a
+///                                    preallocated array with the size of
+///                                    number_of_error_correction_code_words *
+///                                    number_of_messages
+/// @param number_of_error_correction_code_words the number of error correction
+///                                              codewords per message
+/// @param messages the messages the error correction words should be
+///                 calculated for
+/// @param message_length the size of each message
+/// @param number_of_messages the number of messages
 ///
-/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully,
-///         ERROR_CORRECTION_ERROR_OUT_OF_MEMORY if memory allocation fails and
+/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully and
 ///         ERROR_CORRECTION_ERROR_INVALID_PARAMETER if this function is called
 ///         with invalid parameters
 //
-static int polynomialBinaryDivision(uint32_t *format_string,
-                                    size_t *format_string_size,
-                                    uint32_t generator_polynomial,
-                                    const size_t generator_polynomial_size)
+static int generateErrorCorrectionCodewordsBatch(
+    uint8_t *error_correction_code_words,
+    const size_t number_of_error_correction_code_words,
+    const uint8_t *messages, const size_t message_length,
+    const size_t number_of_messages)
 {
-  if(format_string == NULL || format_string_size == NULL)
+  const size_t parity_size = number_of_error_correction_code_words;
+
+  if(error_correction_code_words == NULL ||
+     (messages == NULL && message_length > 0 && number_of_messages > 0) ||
+     parity_size < MIN_ECC_LEN || parity_size > MAX_ECC_LEN)
   {
     return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
   }
 
-  // pad the generator polynomial
-  if(generator_polynomial_size < *format_string_size)
+  uint8_t created_generator_polynomial[MAX_ECC_LEN + 1];
+  const uint8_t *generator_polynomial =
+      loadGeneratorPolynomial(created_generator_polynomial, parity_size);
+  if(generator_polynomial == NULL)
   {
-    generator_polynomial <<= (*format_string_size - generator_polynomial_size);
+    return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
   }
 
-  (*format_string) ^= generator_polynomial;
+  // the lead term of the generator is alpha^0, so it always cancels the
+  // feedback and is skipped
+  struct _Galois256Multiplier_ multipliers[MAX_ECC_LEN];
+  for(size_t term_it = 0; term_it < parity_size; term_it++)
+  {
+    createGalois256Multiplier(&multipliers[term_it],
+        GALOIS_256_FIELDS.exp_field_[generator_polynomial[term_it + 1]]);
+  }
+  const int kernel = selectGalois256Kernel();
 
-  // remove leading zeros
-  while((*format_string_size) > 0 &&
-        !((*format_string) >> (*format_string_size - 1)))
+  // ---------------------------------------------------------------------------
+  // the terms of the registers are a ring, shifting moves the lead term; the
+  // ring is listed twice so the terms from any lead term on are consecutive
+  uint8_t registers[MAX_ECC_LEN][MAX_ECC_BATCH_SIZE];
+  uint8_t *ring[2 * MAX_ECC_LEN];
+  uint8_t feedback[MAX_ECC_BATCH_SIZE];
+
+  for(size_t term_it = 0; term_it < parity_size; term_it++)
+  {
+    ring[term_it] = ring[term_it + parity_size] = registers[term_it];
+  }
+
+  for(size_t first_lane = 0; first_lane < number_of_messages;
+      first_lane += MAX_ECC_BATCH_SIZE)
   {
-    (*format_string_size)--;
+    const size_t lanes = number_of_messages - first_lane < MAX_ECC_BATCH_SIZE ?
+                         number_of_messages - first_lane : MAX_ECC_BATCH_SIZE;
+    // the kernels process whole vectors; the lanes behind the messages get no
+    // feedback, so they stay 0
+    const size_t region = (lanes + MIN_ECC_BATCH_REGION - 1) /
+                          MIN_ECC_BATCH_REGION * MIN_ECC_BATCH_REGION;
+    size_t lead_term = 0;
+
+    for(size_t term_it = 0; term_it < parity_size; term_it++)
+    {
+      memset(registers[term_it], 0, region);
+    }
+    memset(feedback, 0, region);
+
+    for(size_t message_it = 0; message_it < message_length; message_it++)
+    {
+      const uint8_t *code_words =
+          messages + message_it * number_of_messages + first_lane;
+      uint8_t *lead = ring[lead_term];
+
+      for(size_t lane = 0; lane < lanes; lane++)
+      {
+        feedback[lane] = code_words[lane] ^ lead[lane];
+      }
+
+      // the lead term is shifted out and reused as the new last term
+      memset(lead, 0, region);
+      lead_term = lead_term + 1 < parity_size ? lead_term + 1 : 0;
+
+      multiplyAddRegions(kernel, ring + lead_term, feedback, region,
+                         multipliers, parity_size);
+    }
+
+    for(size_t term_it = 0; term_it < parity_size; term_it++)
+    {
+      memcpy(error_correction_code_words + term_it * number_of_messages +
+             first_lane, ring[lead_term + term_it], lanes);
+    }
   }
 
   return ERROR_CORRECTION_RETURN_SUCCESSFUL;
 }
 
 
+//------------------------------------------------------------------------------
+/// Number of format strings, one for every combination of the 2 error
+/// correction level bits and the 3 mask pattern bits
+//
+#define FORMAT_STRING_COUNT 32
+
+//------------------------------------------------------------------------------
+///
+/// The 15 bit format strings indexed by the 5 data bits: the error correction
+/// level bits 01 (L), 00 (M), 11 (Q) or 10 (H) followed by the mask pattern id.
+/// The data bits are followed by the BCH(15,5) remainder of the generator
+/// 0b10100110111, the whole string is XORed with 0b101010000010010.
+//
+static const uint16_t FORMAT_STRINGS[FORMAT_STRING_COUNT] =
+{
+  0x5412, 0x5125, 0x5E7C, 0x5B4B, 0x45F9, 0x40CE, 0x4F97, 0x4AA0,
+  0x77C4, 0x72F3, 0x7DAA, 0x789D, 0x662F, 0x6318, 0x6C41, 0x6976,
+  0x1689, 0x13BE, 0x1CE7, 0x19D0, 0x0762, 0x0255, 0x0D0C, 0x083B,
+  0x355F, 0x3068, 0x3F31, 0x3A06, 0x24B4, 0x2183, 0x2EDA, 0x2BED
+};
+
+//------------------------------------------------------------------------------
+///
+/// The 18 bit version information of the versions MIN_LONG_INFO_VERSION to
+/// MAX_QR_VERSION: the 6 version bits followed by the BCH(18,6) remainder of
+/// the generator 0b1111100100101.
+//
+static const uint32_t VERSION_INFORMATION
+  [MAX_QR_VERSION - MIN_LONG_INFO_VERSION + 1] =
+{
+  0x07C94, 0x085BC, 0x09A99, 0x0A4D3, 0x0BBF6, 0x0C762,
+  0x0D847, 0x0E60D, 0x0F928, 0x10B78, 0x1145D, 0x12A17,
+  0x13532, 0x149A6, 0x15683, 0x168C9, 0x177EC, 0x18EC4,
+  0x191E1, 0x1AFAB, 0x1B08E, 0x1CC1A, 0x1D33F, 0x1ED75,
+  0x1F250, 0x209D5, 0x216F0, 0x228BA, 0x2379F, 0x24B0B,
+  0x2542E, 0x26A64, 0x27541, 0x28C69
+};
+
 //------------------------------------------------------------------------------
 ///
 /// @brief The second core function of this library.
@@ -457,8 +1628,7 @@ static int polynomialBinaryDivision(uint32_t *format_string,
 /// @param mask_pattern_id the mask pattern that is used for the QR-Code matrix
 ///                        the parameter is valid for values between 0 and 7
 ///
-/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully,
-///         ERROR_CORRECTION_ERROR_OUT_OF_MEMORY if memory allocation fails and
+/// @return ERROR_CORRECTION_RETURN_SUCCESSFUL if executes successfully and
 ///         ERROR_CORRECTION_ERROR_INVALID_PARAMETER if this function is called
 ///         with invalid parameters
 //
@@ -480,56 +1650,15 @@ static int generateFormatString(uint32_t *format_string, const int version,
     return ERROR_CORRECTION_ERROR_INVALID_PARAMETER;
   }
 
-  // change the error_correction_level to the appropriate value
-  error_correction_level += (error_correction_level % 2) ? (-1) : (+1);
-
-  uint32_t generator_polynomial = (version < MIN_LONG_INFO_VERSION) ?
-      0b10100110111 : 0b1111100100101;
-
-  size_t generator_polynomial_size = (version < MIN_LONG_INFO_VERSION) ?
-      11 : 13;
-
-  uint32_t error_correction_string = 0;
-  size_t error_correction_string_size = (version < MIN_LONG_INFO_VERSION) ?
-      15 : 18;
-
-  if(version < MIN_LONG_INFO_VERSION)
-  {
-    error_correction_string |=
-        error_correction_level << (error_correction_string_size - 2);
-    error_correction_string |=
-        mask_pattern_id << (error_correction_string_size - 5);
-  }
-  else
-  {
-    error_correction_string |= version << (error_correction_string_size - 6);
-  }
-
-  (*format_string) = error_correction_string;
-
-  // perform polynomial division
-  while(error_correction_string_size > ((version < MIN_LONG_INFO_VERSION) ?
-      10 : 12))
+  if(version >= MIN_LONG_INFO_VERSION)
   {
-    int ret = polynomialBinaryDivision(&error_correction_string,
-                                       &error_correction_string_size,
-                                       generator_polynomial,
-                                       generator_polynomial_size);
-
-    if(ret != ERROR_CORRECTION_RETURN_SUCCESSFUL)
-    {
-      return ret;
-    }
+    (*format_string) = VERSION_INFORMATION[version - MIN_LONG_INFO_VERSION];
+    return ERROR_CORRECTION_RETURN_SUCCESSFUL;
   }
 
-  // add error correction to format string
-  (*format_string) |= error_correction_string;
-
-  // xor with mask string
-  if(version < MIN_LONG_INFO_VERSION)
-  {
-    (*format_string) ^= 0b101010000010010;
-  }
+  // the level bits of L and M as well as Q and H are swapped
+  (*format_string) =
+      FORMAT_STRINGS[((error_correction_level ^ 1) << 3) | mask_pattern_id];
 
   return ERROR_CORRECTION_RETURN_SUCCESSFUL;
 }
@@ -0,0 +1,3477 @@
+//------------------------------------------------------------------------------
+// qrc_encode.h
+//
+// QR - Code encoder library
+//
+// Group: Group C, study assistant Thomas Schwar
+//
+// Authors: Florian Klug 09830971
+// Robin Edlinger 11804235
+//------------------------------------------------------------------------------
+///
+/// @details It is a header-only library that is built on the c standard
+///          library and qrc_ecc.h only. The function qrEncode must be called
+///          to encode a message into a QR-Code matrix, qrEncodeInWorkspace
+///          does the same without heap memory. None of the functions
+///          writes to stdout or terminates the process, errors are reported
+///          by the QR_ENCODE_ return constants. The qr functions are static
+///          inline, a program does not need to call all of them.
+//
+
+#ifndef QRC_ENCODE_H
+#define QRC_ENCODE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+//------------------------------------------------------------------------------
+/// The threads waiting for a table built on first use yield their time slice
+/// with thrd_yield where the C11 threads are available, see 
+/// waitForVersionTable
+//
+#if defined(__has_include) && !defined(__STDC_NO_THREADS__)
+#if __has_include(<threads.h>)
+#define QRC_ENCODE_THREADS
+#include <threads.h>
+#endif
+#endif
+
+#include "qrc_ecc.h"
+
+//------------------------------------------------------------------------------
+/// Return constants used for all functions in this library.
+//
+enum
+{
+  QR_ENCODE_RETURN_SUCCESSFUL = 0,
+  QR_ENCODE_ERROR_OUT_OF_MEMORY = -1,
+  QR_ENCODE_ERROR_INVALID_PARAMETER = -2,
+  QR_ENCODE_ERROR_DATA_TOO_LONG = -3
+};
+
+//------------------------------------------------------------------------------
+/// Limits of the largest supported QR-flavor. A payload of digits only fits 
+/// the most bytes, one in byte mode the fewest.
+//
+#define QR_MAX_INPUT_SIZE 7089
+#define QR_MAX_ALPHANUMERIC_INPUT_SIZE 4296
+#define QR_MAX_BYTE_INPUT_SIZE 2953
+#define QR_MAX_DATA_CODEWORDS 2956
+#define QR_MAX_EC_CODEWORDS 2430
+#define QR_MAX_CODEWORDS 3706
+#define QR_MAX_MATRIX_SIZE 177
+#define QR_MAX_BLOCKS 81
+#define QR_MAX_BLOCK_DATA_CODEWORDS 123
+#define QR_MAX_ALIGNMENT_PATTERNS 7
+
+//------------------------------------------------------------------------------
+/// Number of 64 bit words a packed matrix row consists of
+//
+#define QR_MATRIX_ROW_WORDS ((QR_MAX_MATRIX_SIZE + 63) / 64)
+
+static const uint8_t NUMBER_OF_QR_FLAVORS = 160;
+static const uint8_t SYNC_PATTERN_POS = 6;
+static const uint8_t FORMAT_VERSION_LENGTH = 15;
+static const uint8_t VERSION_INFO_LENGTH = 18;
+static const uint8_t VERSION_INFO_ROWS = 3;
+static const uint8_t MIN_LONG_COUNT_VERSION = 10;
+
+//------------------------------------------------------------------------------
+/// Number of mask patterns, every pattern repeats after MASK_PATTERN_PERIOD 
+/// columns
+//
+#define MASK_PATTERN_COUNT 8
+#define MASK_PATTERN_PERIOD 6
+
+//------------------------------------------------------------------------------
+/// Penalty weights of the mask evaluation: runs of 5 or more equal modules
+/// (N1, plus 1 per further module), 2x2 blocks of equal modules (N2), finder
+/// like 1:1:3:1:1 patterns next to 4 light modules (N3) and every 5% the dark
+/// modules differ from 50% (N4)
+//
+static const uint8_t PENALTY_N1 = 3;
+static const uint8_t PENALTY_N2 = 3;
+static const uint8_t PENALTY_N3 = 40;
+static const uint8_t PENALTY_N4 = 10;
+
+
+#define POS_PATTERN_SIZE 7
+static const uint8_t POS_PATTERN[POS_PATTERN_SIZE][POS_PATTERN_SIZE] =
+{
+  {1, 1, 1, 1, 1, 1, 1},
+  {1, 0, 0, 0, 0, 0, 1},
+  {1, 0, 1, 1, 1, 0, 1},
+  {1, 0, 1, 1, 1, 0, 1},
+  {1, 0, 1, 1, 1, 0, 1},
+  {1, 0, 0, 0, 0, 0, 1},
+  {1, 1, 1, 1, 1, 1, 1}
+};
+
+#define ALIGNMENT_PATTERN_SIZE 5
+static const uint8_t 
+ALIGNMENT_PATTERN[ALIGNMENT_PATTERN_SIZE][ALIGNMENT_PATTERN_SIZE] =
+{
+  {1, 1, 1, 1, 1},
+  {1, 0, 0, 0, 1},
+  {1, 0, 1, 0, 1},
+  {1, 0, 0, 0, 1},
+  {1, 1, 1, 1, 1}
+};
+
+enum {
+  UP = -1,
+  DOWN = 1
+};
+
+enum {
+  LEFT = -1,
+  RIGHT = 1
+};
+
+//------------------------------------------------------------------------------
+/// Segment modes, a message is a sequence of segments which start with the 4 
+/// bit mode indicator and the character count. Kanji characters are the 
+/// double byte Shift JIS characters 0x8140 to 0x9FFC and 0xE040 to 0xEBBF.
+//
+enum
+{
+  SEGMENT_NUMERIC = 0,
+  SEGMENT_ALPHANUMERIC = 1,
+  SEGMENT_BYTE = 2,
+  SEGMENT_KANJI = 3
+};
+
+#define SEGMENT_MODE_COUNT 4
+static const uint8_t MODE_INDICATOR_LENGTH = 4;
+static const uint8_t SEGMENT_MODE_INDICATORS[SEGMENT_MODE_COUNT] = 
+  {0x01, 0x02, 0x04, 0x08};
+
+//------------------------------------------------------------------------------
+/// Length of the character count per segment mode for the versions below 
+/// MIN_LONG_COUNT_VERSION, below MIN_LONGEST_COUNT_VERSION and from it on, 
+/// see getCountGroup. A segment longer than its count allows never fits into
+/// the largest version of the group, so segments are never split.
+//
+#define COUNT_GROUPS 3
+static const uint8_t MIN_LONGEST_COUNT_VERSION = 27;
+static const uint8_t COUNT_LENGTHS[SEGMENT_MODE_COUNT][COUNT_GROUPS] =
+{
+  {10, 12, 14},
+  { 9, 11, 13},
+  { 8, 16, 16},
+  { 8, 10, 12}
+};
+
+//------------------------------------------------------------------------------
+/// Number of 64 bit words of a packed character class mask of \p len bytes
+/// and number of masks, see _CharacterClasses_
+//
+#define CHARACTER_CLASS_WORDS(len) (((len) + 63) / 64)
+#define CHARACTER_CLASS_COUNT 3
+
+//------------------------------------------------------------------------------
+///
+/// The segment modes every payload byte can be encoded with, bit i of a mask
+/// belongs to byte i. Every byte fits into byte mode, a Kanji bit marks the 
+/// first byte of a Kanji character. Each mask has CHARACTER_CLASS_WORDS 
+/// words of the payload length.
+//
+struct _CharacterClasses_
+{
+  uint64_t *numeric_;
+  uint64_t *alphanumeric_;
+  uint64_t *kanji_;
+};
+
+//------------------------------------------------------------------------------
+///
+/// States of the segmentation, see segmentPayload. A numeric segment packs 3
+/// digits into 10 bits and an alphanumeric segment 2 characters into 11 bits,
+/// so their states count the characters of the open group. The bits are the
+/// ones a character adds when it enters the state. NO_SEGMENT_STATE is the
+/// state before the first byte.
+//
+enum
+{
+  SEGMENT_STATE_NUMERIC_1 = 0,
+  SEGMENT_STATE_NUMERIC_2 = 1,
+  SEGMENT_STATE_NUMERIC_3 = 2,
+  SEGMENT_STATE_ALPHANUMERIC_1 = 3,
+  SEGMENT_STATE_ALPHANUMERIC_2 = 4,
+  SEGMENT_STATE_BYTE = 5,
+  SEGMENT_STATE_KANJI = 6
+};
+
+#define SEGMENT_STATE_COUNT 7
+#define NO_SEGMENT_STATE SEGMENT_STATE_COUNT
+static const uint8_t SEGMENT_STATE_MODES[SEGMENT_STATE_COUNT] = 
+{
+  SEGMENT_NUMERIC, SEGMENT_NUMERIC, SEGMENT_NUMERIC, SEGMENT_ALPHANUMERIC, 
+  SEGMENT_ALPHANUMERIC, SEGMENT_BYTE, SEGMENT_KANJI
+};
+static const uint8_t SEGMENT_STATE_BITS[SEGMENT_STATE_COUNT] = 
+  {4, 3, 3, 6, 5, 8, 13};
+// the state of the previous character of the same segment
+static const uint8_t SEGMENT_STATE_PREVIOUS[SEGMENT_STATE_COUNT] = 
+{
+  SEGMENT_STATE_NUMERIC_3, SEGMENT_STATE_NUMERIC_1, SEGMENT_STATE_NUMERIC_2,
+  SEGMENT_STATE_ALPHANUMERIC_2, SEGMENT_STATE_ALPHANUMERIC_1, 
+  SEGMENT_STATE_BYTE, SEGMENT_STATE_KANJI
+};
+// the state of the first character of a segment, per segment mode
+static const uint8_t SEGMENT_FIRST_STATES[SEGMENT_MODE_COUNT] = 
+{
+  SEGMENT_STATE_NUMERIC_1, SEGMENT_STATE_ALPHANUMERIC_1, SEGMENT_STATE_BYTE,
+  SEGMENT_STATE_KANJI
+};
+
+struct _MessageData_ 
+{
+  uint16_t data_len_;
+  const unsigned char *data_;
+  // the segment state of every byte, see segmentPayload, or NULL to encode 
+  // the message as a single byte mode segment
+  const uint16_t *states_;
+};
+
+//------------------------------------------------------------------------------
+///
+/// Version and error correction level of a QR-Code. The data codewords are 
+/// split into blocks_ blocks with ec_data_ error correction codewords each; if
+/// they do not divide evenly, the last blocks hold one data codeword more.
+/// The flavors are ordered by version and from the most robust level on, see
+/// selectFlavor.
+//
+struct _QRFlavor_ 
+{
+  // the max payload in bytes of a single byte mode segment
+  uint16_t capacity_;
+  uint8_t version_;
+  unsigned char ec_level_;
+  // the error correction codewords per block
+  uint8_t ec_data_;
+  uint8_t blocks_;
+  uint16_t data_codewords_;
+}; 
+
+//------------------------------------------------------------------------------
+///
+/// Function patterns of a QR-Code version. The alignment patterns are centered
+/// on every combination of the listed rows and columns which does not overlap
+/// a position pattern.
+//
+struct _QRVersion_
+{
+  // the alignment pattern rows and columns, 0 terminated
+  uint8_t alignment_pattern_pos_[QR_MAX_ALIGNMENT_PATTERNS];
+  // the 18 bit version information, 0 below MIN_LONG_INFO_VERSION
+  uint32_t version_info_;
+};
+
+static const struct _QRFlavor_ QRFlavors[] = 
+{
+  {.capacity_ =    7, .version_ =  1, .ec_level_ = 'H', .ec_data_ = 17, 
+    .blocks_ =  1, .data_codewords_ =    9},
+  {.capacity_ =   11, .version_ =  1, .ec_level_ = 'Q', .ec_data_ = 13, 
+    .blocks_ =  1, .data_codewords_ =   13},
+  {.capacity_ =   14, .version_ =  1, .ec_level_ = 'M', .ec_data_ = 10, 
+    .blocks_ =  1, .data_codewords_ =   16},
+  {.capacity_ =   17, .version_ =  1, .ec_level_ = 'L', .ec_data_ =  7, 
+    .blocks_ =  1, .data_codewords_ =   19},
+  {.capacity_ =   14, .version_ =  2, .ec_level_ = 'H', .ec_data_ = 28, 
+    .blocks_ =  1, .data_codewords_ =   16},
+  {.capacity_ =   20, .version_ =  2, .ec_level_ = 'Q', .ec_data_ = 22, 
+    .blocks_ =  1, .data_codewords_ =   22},
+  {.capacity_ =   26, .version_ =  2, .ec_level_ = 'M', .ec_data_ = 16, 
+    .blocks_ =  1, .data_codewords_ =   28},
+  {.capacity_ =   32, .version_ =  2, .ec_level_ = 'L', .ec_data_ = 10, 
+    .blocks_ =  1, .data_codewords_ =   34},
+  {.capacity_ =   24, .version_ =  3, .ec_level_ = 'H', .ec_data_ = 22, 
+    .blocks_ =  2, .data_codewords_ =   26},
+  {.capacity_ =   32, .version_ =  3, .ec_level_ = 'Q', .ec_data_ = 18, 
+    .blocks_ =  2, .data_codewords_ =   34},
+  {.capacity_ =   42, .version_ =  3, .ec_level_ = 'M', .ec_data_ = 26, 
+    .blocks_ =  1, .data_codewords_ =   44},
+  {.capacity_ =   53, .version_ =  3, .ec_level_ = 'L', .ec_data_ = 15, 
+    .blocks_ =  1, .data_codewords_ =   55},
+  {.capacity_ =   34, .version_ =  4, .ec_level_ = 'H', .ec_data_ = 16, 
+    .blocks_ =  4, .data_codewords_ =   36},
+  {.capacity_ =   46, .version_ =  4, .ec_level_ = 'Q', .ec_data_ = 26, 
+    .blocks_ =  2, .data_codewords_ =   48},
+  {.capacity_ =   62, .version_ =  4, .ec_level_ = 'M', .ec_data_ = 18, 
+    .blocks_ =  2, .data_codewords_ =   64},
+  {.capacity_ =   78, .version_ =  4, .ec_level_ = 'L', .ec_data_ = 20, 
+    .blocks_ =  1, .data_codewords_ =   80},
+  {.capacity_ =   44, .version_ =  5, .ec_level_ = 'H', .ec_data_ = 22, 
+    .blocks_ =  4, .data_codewords_ =   46},
+  {.capacity_ =   60, .version_ =  5, .ec_level_ = 'Q', .ec_data_ = 18, 
+    .blocks_ =  4, .data_codewords_ =   62},
+  {.capacity_ =   84, .version_ =  5, .ec_level_ = 'M', .ec_data_ = 24, 
+    .blocks_ =  2, .data_codewords_ =   86},
+  {.capacity_ =  106, .version_ =  5, .ec_level_ = 'L', .ec_data_ = 26, 
+    .blocks_ =  1, .data_codewords_ =  108},
+  {.capacity_ =   58, .version_ =  6, .ec_level_ = 'H', .ec_data_ = 28, 
+    .blocks_ =  4, .data_codewords_ =   60},
+  {.capacity_ =   74, .version_ =  6, .ec_level_ = 'Q', .ec_data_ = 24, 
+    .blocks_ =  4, .data_codewords_ =   76},
+  {.capacity_ =  106, .version_ =  6, .ec_level_ = 'M', .ec_data_ = 16, 
+    .blocks_ =  4, .data_codewords_ =  108},
+  {.capacity_ =  134, .version_ =  6, .ec_level_ = 'L', .ec_data_ = 18, 
+    .blocks_ =  2, .data_codewords_ =  136},
+  {.capacity_ =   64, .version_ =  7, .ec_level_ = 'H', .ec_data_ = 26, 
+    .blocks_ =  5, .data_codewords_ =   66},
+  {.capacity_ =   86, .version_ =  7, .ec_level_ = 'Q', .ec_data_ = 18, 
+    .blocks_ =  6, .data_codewords_ =   88},
+  {.capacity_ =  122, .version_ =  7, .ec_level_ = 'M', .ec_data_ = 18, 
+    .blocks_ =  4, .data_codewords_ =  124},
+  {.capacity_ =  154, .version_ =  7, .ec_level_ = 'L', .ec_data_ = 20, 
+    .blocks_ =  2, .data_codewords_ =  156},
+  {.capacity_ =   84, .version_ =  8, .ec_level_ = 'H', .ec_data_ = 26, 
+    .blocks_ =  6, .data_codewords_ =   86},
+  {.capacity_ =  108, .version_ =  8, .ec_level_ = 'Q', .ec_data_ = 22, 
+    .blocks_ =  6, .data_codewords_ =  110},
+  {.capacity_ =  152, .version_ =  8, .ec_level_ = 'M', .ec_data_ = 22, 
+    .blocks_ =  4, .data_codewords_ =  154},
+  {.capacity_ =  192, .version_ =  8, .ec_level_ = 'L', .ec_data_ = 24, 
+    .blocks_ =  2, .data_codewords_ =  194},
+  {.capacity_ =   98, .version_ =  9, .ec_level_ = 'H', .ec_data_ = 24, 
+    .blocks_ =  8, .data_codewords_ =  100},
+  {.capacity_ =  130, .version_ =  9, .ec_level_ = 'Q', .ec_data_ = 20, 
+    .blocks_ =  8, .data_codewords_ =  132},
+  {.capacity_ =  180, .version_ =  9, .ec_level_ = 'M', .ec_data_ = 22, 
+    .blocks_ =  5, .data_codewords_ =  182},
+  {.capacity_ =  230, .version_ =  9, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ =  2, .data_codewords_ =  232},
+  {.capacity_ =  119, .version_ = 10, .ec_level_ = 'H', .ec_data_ = 28, 
+    .blocks_ =  8, .data_codewords_ =  122},
+  {.capacity_ =  151, .version_ = 10, .ec_level_ = 'Q', .ec_data_ = 24, 
+    .blocks_ =  8, .data_codewords_ =  154},
+  {.capacity_ =  213, .version_ = 10, .ec_level_ = 'M', .ec_data_ = 26, 
+    .blocks_ =  5, .data_codewords_ =  216},
+  {.capacity_ =  271, .version_ = 10, .ec_level_ = 'L', .ec_data_ = 18, 
+    .blocks_ =  4, .data_codewords_ =  274},
+  {.capacity_ =  137, .version_ = 11, .ec_level_ = 'H', .ec_data_ = 24, 
+    .blocks_ = 11, .data_codewords_ =  140},
+  {.capacity_ =  177, .version_ = 11, .ec_level_ = 'Q', .ec_data_ = 28, 
+    .blocks_ =  8, .data_codewords_ =  180},
+  {.capacity_ =  251, .version_ = 11, .ec_level_ = 'M', .ec_data_ = 30, 
+    .blocks_ =  5, .data_codewords_ =  254},
+  {.capacity_ =  321, .version_ = 11, .ec_level_ = 'L', .ec_data_ = 20, 
+    .blocks_ =  4, .data_codewords_ =  324},
+  {.capacity_ =  155, .version_ = 12, .ec_level_ = 'H', .ec_data_ = 28, 
+    .blocks_ = 11, .data_codewords_ =  158},
+  {.capacity_ =  203, .version_ = 12, .ec_level_ = 'Q', .ec_data_ = 26, 
+    .blocks_ = 10, .data_codewords_ =  206},
+  {.capacity_ =  287, .version_ = 12, .ec_level_ = 'M', .ec_data_ = 22, 
+    .blocks_ =  8, .data_codewords_ =  290},
+  {.capacity_ =  367, .version_ = 12, .ec_level_ = 'L', .ec_data_ = 24, 
+    .blocks_ =  4, .data_codewords_ =  370},
+  {.capacity_ =  177, .version_ = 13, .ec_level_ = 'H', .ec_data_ = 22, 
+    .blocks_ = 16, .data_codewords_ =  180},
+  {.capacity_ =  241, .version_ = 13, .ec_level_ = 'Q', .ec_data_ = 24, 
+    .blocks_ = 12, .data_codewords_ =  244},
+  {.capacity_ =  331, .version_ = 13, .ec_level_ = 'M', .ec_data_ = 22, 
+    .blocks_ =  9, .data_codewords_ =  334},
+  {.capacity_ =  425, .version_ = 13, .ec_level_ = 'L', .ec_data_ = 26, 
+    .blocks_ =  4, .data_codewords_ =  428},
+  {.capacity_ =  194, .version_ = 14, .ec_level_ = 'H', .ec_data_ = 24, 
+    .blocks_ = 16, .data_codewords_ =  197},
+  {.capacity_ =  258, .version_ = 14, .ec_level_ = 'Q', .ec_data_ = 20, 
+    .blocks_ = 16, .data_codewords_ =  261},
+  {.capacity_ =  362, .version_ = 14, .ec_level_ = 'M', .ec_data_ = 24, 
+    .blocks_ =  9, .data_codewords_ =  365},
+  {.capacity_ =  458, .version_ = 14, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ =  4, .data_codewords_ =  461},
+  {.capacity_ =  220, .version_ = 15, .ec_level_ = 'H', .ec_data_ = 24, 
+    .blocks_ = 18, .data_codewords_ =  223},
+  {.capacity_ =  292, .version_ = 15, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 12, .data_codewords_ =  295},
+  {.capacity_ =  412, .version_ = 15, .ec_level_ = 'M', .ec_data_ = 24, 
+    .blocks_ = 10, .data_codewords_ =  415},
+  {.capacity_ =  520, .version_ = 15, .ec_level_ = 'L', .ec_data_ = 22, 
+    .blocks_ =  6, .data_codewords_ =  523},
+  {.capacity_ =  250, .version_ = 16, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 16, .data_codewords_ =  253},
+  {.capacity_ =  322, .version_ = 16, .ec_level_ = 'Q', .ec_data_ = 24, 
+    .blocks_ = 17, .data_codewords_ =  325},
+  {.capacity_ =  450, .version_ = 16, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 10, .data_codewords_ =  453},
+  {.capacity_ =  586, .version_ = 16, .ec_level_ = 'L', .ec_data_ = 24, 
+    .blocks_ =  6, .data_codewords_ =  589},
+  {.capacity_ =  280, .version_ = 17, .ec_level_ = 'H', .ec_data_ = 28, 
+    .blocks_ = 19, .data_codewords_ =  283},
+  {.capacity_ =  364, .version_ = 17, .ec_level_ = 'Q', .ec_data_ = 28, 
+    .blocks_ = 16, .data_codewords_ =  367},
+  {.capacity_ =  504, .version_ = 17, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 11, .data_codewords_ =  507},
+  {.capacity_ =  644, .version_ = 17, .ec_level_ = 'L', .ec_data_ = 28, 
+    .blocks_ =  6, .data_codewords_ =  647},
+  {.capacity_ =  310, .version_ = 18, .ec_level_ = 'H', .ec_data_ = 28, 
+    .blocks_ = 21, .data_codewords_ =  313},
+  {.capacity_ =  394, .version_ = 18, .ec_level_ = 'Q', .ec_data_ = 28, 
+    .blocks_ = 18, .data_codewords_ =  397},
+  {.capacity_ =  560, .version_ = 18, .ec_level_ = 'M', .ec_data_ = 26, 
+    .blocks_ = 13, .data_codewords_ =  563},
+  {.capacity_ =  718, .version_ = 18, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ =  6, .data_codewords_ =  721},
+  {.capacity_ =  338, .version_ = 19, .ec_level_ = 'H', .ec_data_ = 26, 
+    .blocks_ = 25, .data_codewords_ =  341},
+  {.capacity_ =  442, .version_ = 19, .ec_level_ = 'Q', .ec_data_ = 26, 
+    .blocks_ = 21, .data_codewords_ =  445},
+  {.capacity_ =  624, .version_ = 19, .ec_level_ = 'M', .ec_data_ = 26, 
+    .blocks_ = 14, .data_codewords_ =  627},
+  {.capacity_ =  792, .version_ = 19, .ec_level_ = 'L', .ec_data_ = 28, 
+    .blocks_ =  7, .data_codewords_ =  795},
+  {.capacity_ =  382, .version_ = 20, .ec_level_ = 'H', .ec_data_ = 28, 
+    .blocks_ = 25, .data_codewords_ =  385},
+  {.capacity_ =  482, .version_ = 20, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 20, .data_codewords_ =  485},
+  {.capacity_ =  666, .version_ = 20, .ec_level_ = 'M', .ec_data_ = 26, 
+    .blocks_ = 16, .data_codewords_ =  669},
+  {.capacity_ =  858, .version_ = 20, .ec_level_ = 'L', .ec_data_ = 28, 
+    .blocks_ =  8, .data_codewords_ =  861},
+  {.capacity_ =  403, .version_ = 21, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 25, .data_codewords_ =  406},
+  {.capacity_ =  509, .version_ = 21, .ec_level_ = 'Q', .ec_data_ = 28, 
+    .blocks_ = 23, .data_codewords_ =  512},
+  {.capacity_ =  711, .version_ = 21, .ec_level_ = 'M', .ec_data_ = 26, 
+    .blocks_ = 17, .data_codewords_ =  714},
+  {.capacity_ =  929, .version_ = 21, .ec_level_ = 'L', .ec_data_ = 28, 
+    .blocks_ =  8, .data_codewords_ =  932},
+  {.capacity_ =  439, .version_ = 22, .ec_level_ = 'H', .ec_data_ = 24, 
+    .blocks_ = 34, .data_codewords_ =  442},
+  {.capacity_ =  565, .version_ = 22, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 23, .data_codewords_ =  568},
+  {.capacity_ =  779, .version_ = 22, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 17, .data_codewords_ =  782},
+  {.capacity_ = 1003, .version_ = 22, .ec_level_ = 'L', .ec_data_ = 28, 
+    .blocks_ =  9, .data_codewords_ = 1006},
+  {.capacity_ =  461, .version_ = 23, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 30, .data_codewords_ =  464},
+  {.capacity_ =  611, .version_ = 23, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 25, .data_codewords_ =  614},
+  {.capacity_ =  857, .version_ = 23, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 18, .data_codewords_ =  860},
+  {.capacity_ = 1091, .version_ = 23, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ =  9, .data_codewords_ = 1094},
+  {.capacity_ =  511, .version_ = 24, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 32, .data_codewords_ =  514},
+  {.capacity_ =  661, .version_ = 24, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 27, .data_codewords_ =  664},
+  {.capacity_ =  911, .version_ = 24, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 20, .data_codewords_ =  914},
+  {.capacity_ = 1171, .version_ = 24, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 10, .data_codewords_ = 1174},
+  {.capacity_ =  535, .version_ = 25, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 35, .data_codewords_ =  538},
+  {.capacity_ =  715, .version_ = 25, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 29, .data_codewords_ =  718},
+  {.capacity_ =  997, .version_ = 25, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 21, .data_codewords_ = 1000},
+  {.capacity_ = 1273, .version_ = 25, .ec_level_ = 'L', .ec_data_ = 26, 
+    .blocks_ = 12, .data_codewords_ = 1276},
+  {.capacity_ =  593, .version_ = 26, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 37, .data_codewords_ =  596},
+  {.capacity_ =  751, .version_ = 26, .ec_level_ = 'Q', .ec_data_ = 28, 
+    .blocks_ = 34, .data_codewords_ =  754},
+  {.capacity_ = 1059, .version_ = 26, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 23, .data_codewords_ = 1062},
+  {.capacity_ = 1367, .version_ = 26, .ec_level_ = 'L', .ec_data_ = 28, 
+    .blocks_ = 12, .data_codewords_ = 1370},
+  {.capacity_ =  625, .version_ = 27, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 40, .data_codewords_ =  628},
+  {.capacity_ =  805, .version_ = 27, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 34, .data_codewords_ =  808},
+  {.capacity_ = 1125, .version_ = 27, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 25, .data_codewords_ = 1128},
+  {.capacity_ = 1465, .version_ = 27, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 12, .data_codewords_ = 1468},
+  {.capacity_ =  658, .version_ = 28, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 42, .data_codewords_ =  661},
+  {.capacity_ =  868, .version_ = 28, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 35, .data_codewords_ =  871},
+  {.capacity_ = 1190, .version_ = 28, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 26, .data_codewords_ = 1193},
+  {.capacity_ = 1528, .version_ = 28, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 13, .data_codewords_ = 1531},
+  {.capacity_ =  698, .version_ = 29, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 45, .data_codewords_ =  701},
+  {.capacity_ =  908, .version_ = 29, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 38, .data_codewords_ =  911},
+  {.capacity_ = 1264, .version_ = 29, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 28, .data_codewords_ = 1267},
+  {.capacity_ = 1628, .version_ = 29, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 14, .data_codewords_ = 1631},
+  {.capacity_ =  742, .version_ = 30, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 48, .data_codewords_ =  745},
+  {.capacity_ =  982, .version_ = 30, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 40, .data_codewords_ =  985},
+  {.capacity_ = 1370, .version_ = 30, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 29, .data_codewords_ = 1373},
+  {.capacity_ = 1732, .version_ = 30, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 15, .data_codewords_ = 1735},
+  {.capacity_ =  790, .version_ = 31, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 51, .data_codewords_ =  793},
+  {.capacity_ = 1030, .version_ = 31, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 43, .data_codewords_ = 1033},
+  {.capacity_ = 1452, .version_ = 31, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 31, .data_codewords_ = 1455},
+  {.capacity_ = 1840, .version_ = 31, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 16, .data_codewords_ = 1843},
+  {.capacity_ =  842, .version_ = 32, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 54, .data_codewords_ =  845},
+  {.capacity_ = 1112, .version_ = 32, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 45, .data_codewords_ = 1115},
+  {.capacity_ = 1538, .version_ = 32, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 33, .data_codewords_ = 1541},
+  {.capacity_ = 1952, .version_ = 32, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 17, .data_codewords_ = 1955},
+  {.capacity_ =  898, .version_ = 33, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 57, .data_codewords_ =  901},
+  {.capacity_ = 1168, .version_ = 33, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 48, .data_codewords_ = 1171},
+  {.capacity_ = 1628, .version_ = 33, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 35, .data_codewords_ = 1631},
+  {.capacity_ = 2068, .version_ = 33, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 18, .data_codewords_ = 2071},
+  {.capacity_ =  958, .version_ = 34, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 60, .data_codewords_ =  961},
+  {.capacity_ = 1228, .version_ = 34, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 51, .data_codewords_ = 1231},
+  {.capacity_ = 1722, .version_ = 34, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 37, .data_codewords_ = 1725},
+  {.capacity_ = 2188, .version_ = 34, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 19, .data_codewords_ = 2191},
+  {.capacity_ =  983, .version_ = 35, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 63, .data_codewords_ =  986},
+  {.capacity_ = 1283, .version_ = 35, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 53, .data_codewords_ = 1286},
+  {.capacity_ = 1809, .version_ = 35, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 38, .data_codewords_ = 1812},
+  {.capacity_ = 2303, .version_ = 35, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 19, .data_codewords_ = 2306},
+  {.capacity_ = 1051, .version_ = 36, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 66, .data_codewords_ = 1054},
+  {.capacity_ = 1351, .version_ = 36, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 56, .data_codewords_ = 1354},
+  {.capacity_ = 1911, .version_ = 36, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 40, .data_codewords_ = 1914},
+  {.capacity_ = 2431, .version_ = 36, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 20, .data_codewords_ = 2434},
+  {.capacity_ = 1093, .version_ = 37, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 70, .data_codewords_ = 1096},
+  {.capacity_ = 1423, .version_ = 37, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 59, .data_codewords_ = 1426},
+  {.capacity_ = 1989, .version_ = 37, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 43, .data_codewords_ = 1992},
+  {.capacity_ = 2563, .version_ = 37, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 21, .data_codewords_ = 2566},
+  {.capacity_ = 1139, .version_ = 38, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 74, .data_codewords_ = 1142},
+  {.capacity_ = 1499, .version_ = 38, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 62, .data_codewords_ = 1502},
+  {.capacity_ = 2099, .version_ = 38, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 45, .data_codewords_ = 2102},
+  {.capacity_ = 2699, .version_ = 38, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 22, .data_codewords_ = 2702},
+  {.capacity_ = 1219, .version_ = 39, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 77, .data_codewords_ = 1222},
+  {.capacity_ = 1579, .version_ = 39, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 65, .data_codewords_ = 1582},
+  {.capacity_ = 2213, .version_ = 39, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 47, .data_codewords_ = 2216},
+  {.capacity_ = 2809, .version_ = 39, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 24, .data_codewords_ = 2812},
+  {.capacity_ = 1273, .version_ = 40, .ec_level_ = 'H', .ec_data_ = 30, 
+    .blocks_ = 81, .data_codewords_ = 1276},
+  {.capacity_ = 1663, .version_ = 40, .ec_level_ = 'Q', .ec_data_ = 30, 
+    .blocks_ = 68, .data_codewords_ = 1666},
+  {.capacity_ = 2331, .version_ = 40, .ec_level_ = 'M', .ec_data_ = 28, 
+    .blocks_ = 49, .data_codewords_ = 2334},
+  {.capacity_ = 2953, .version_ = 40, .ec_level_ = 'L', .ec_data_ = 30, 
+    .blocks_ = 25, .data_codewords_ = 2956},
+};
+
+static const struct _QRVersion_ QRVersions[MAX_QR_VERSION] = 
+{
+  {.alignment_pattern_pos_ = {0}, 
+    .version_info_ = 0x00000},
+  {.alignment_pattern_pos_ = {6, 18}, 
+    .version_info_ = 0x00000},
+  {.alignment_pattern_pos_ = {6, 22}, 
+    .version_info_ = 0x00000},
+  {.alignment_pattern_pos_ = {6, 26}, 
+    .version_info_ = 0x00000},
+  {.alignment_pattern_pos_ = {6, 30}, 
+    .version_info_ = 0x00000},
+  {.alignment_pattern_pos_ = {6, 34}, 
+    .version_info_ = 0x00000},
+  {.alignment_pattern_pos_ = {6, 22, 38}, 
+    .version_info_ = 0x07C94},
+  {.alignment_pattern_pos_ = {6, 24, 42}, 
+    .version_info_ = 0x085BC},
+  {.alignment_pattern_pos_ = {6, 26, 46}, 
+    .version_info_ = 0x09A99},
+  {.alignment_pattern_pos_ = {6, 28, 50}, 
+    .version_info_ = 0x0A4D3},
+  {.alignment_pattern_pos_ = {6, 30, 54}, 
+    .version_info_ = 0x0BBF6},
+  {.alignment_pattern_pos_ = {6, 32, 58}, 
+    .version_info_ = 0x0C762},
+  {.alignment_pattern_pos_ = {6, 34, 62}, 
+    .version_info_ = 0x0D847},
+  {.alignment_pattern_pos_ = {6, 26, 46, 66}, 
+    .version_info_ = 0x0E60D},
+  {.alignment_pattern_pos_ = {6, 26, 48, 70}, 
+    .version_info_ = 0x0F928},
+  {.alignment_pattern_pos_ = {6, 26, 50, 74}, 
+    .version_info_ = 0x10B78},
+  {.alignment_pattern_pos_ = {6, 30, 54, 78}, 
+    .version_info_ = 0x1145D},
+  {.alignment_pattern_pos_ = {6, 30, 56, 82}, 
+    .version_info_ = 0x12A17},
+  {.alignment_pattern_pos_ = {6, 30, 58, 86}, 
+    .version_info_ = 0x13532},
+  {.alignment_pattern_pos_ = {6, 34, 62, 90}, 
+    .version_info_ = 0x149A6},
+  {.alignment_pattern_pos_ = {6, 28, 50, 72, 94}, 
+    .version_info_ = 0x15683},
+  {.alignment_pattern_pos_ = {6, 26, 50, 74, 98}, 
+    .version_info_ = 0x168C9},
+  {.alignment_pattern_pos_ = {6, 30, 54, 78, 102}, 
+    .version_info_ = 0x177EC},
+  {.alignment_pattern_pos_ = {6, 28, 54, 80, 106}, 
+    .version_info_ = 0x18EC4},
+  {.alignment_pattern_pos_ = {6, 32, 58, 84, 110}, 
+    .version_info_ = 0x191E1},
+  {.alignment_pattern_pos_ = {6, 30, 58, 86, 114}, 
+    .version_info_ = 0x1AFAB},
+  {.alignment_pattern_pos_ = {6, 34, 62, 90, 118}, 
+    .version_info_ = 0x1B08E},
+  {.alignment_pattern_pos_ = {6, 26, 50, 74, 98, 122}, 
+    .version_info_ = 0x1CC1A},
+  {.alignment_pattern_pos_ = {6, 30, 54, 78, 102, 126}, 
+    .version_info_ = 0x1D33F},
+  {.alignment_pattern_pos_ = {6, 26, 52, 78, 104, 130}, 
+    .version_info_ = 0x1ED75},
+  {.alignment_pattern_pos_ = {6, 30, 56, 82, 108, 134}, 
+    .version_info_ = 0x1F250},
+  {.alignment_pattern_pos_ = {6, 34, 60, 86, 112, 138}, 
+    .version_info_ = 0x209D5},
+  {.alignment_pattern_pos_ = {6, 30, 58, 86, 114, 142}, 
+    .version_info_ = 0x216F0},
+  {.alignment_pattern_pos_ = {6, 34, 62, 90, 118, 146}, 
+    .version_info_ = 0x228BA},
+  {.alignment_pattern_pos_ = {6, 30, 54, 78, 102, 126, 150}, 
+    .version_info_ = 0x2379F},
+  {.alignment_pattern_pos_ = {6, 24, 50, 76, 102, 128, 154}, 
+    .version_info_ = 0x24B0B},
+  {.alignment_pattern_pos_ = {6, 28, 54, 80, 106, 132, 158}, 
+    .version_info_ = 0x2542E},
+  {.alignment_pattern_pos_ = {6, 32, 58, 84, 110, 136, 162}, 
+    .version_info_ = 0x26A64},
+  {.alignment_pattern_pos_ = {6, 26, 54, 82, 110, 138, 166}, 
+    .version_info_ = 0x27541},
+  {.alignment_pattern_pos_ = {6, 30, 58, 86, 114, 142, 170}, 
+    .version_info_ = 0x28C69},
+};
+
+//------------------------------------------------------------------------------
+///
+/// Packed QR-Code matrix, one bit per module. Module (row, col) is bit col % 64
+/// of word col / 64 of the row.
+//
+struct _QRMatrix_
+{
+  uint8_t size_;
+  uint64_t modules_[QR_MAX_MATRIX_SIZE][QR_MATRIX_ROW_WORDS];
+};
+
+//------------------------------------------------------------------------------
+/// Number of bits of a _QRMatrix_ row, module (row, col) is bit 
+/// row * QR_MATRIX_ROW_BITS + col of the matrix
+//
+#define QR_MATRIX_ROW_BITS (QR_MATRIX_ROW_WORDS * 64)
+
+//------------------------------------------------------------------------------
+///
+/// Matrix under construction, every plane is the matrix size rows in the 
+/// layout of the rows of _QRMatrix_, see createBitplanes
+//
+struct _QRBitplanes_
+{
+  // the module values
+  uint64_t (*values_)[QR_MATRIX_ROW_WORDS];
+  // the modules of the function patterns and of the format and version 
+  // information
+  uint64_t (*function_)[QR_MATRIX_ROW_WORDS];
+  // all other modules, they hold the codewords and are masked
+  uint64_t (*data_)[QR_MATRIX_ROW_WORDS];
+};
+
+//------------------------------------------------------------------------------
+/// Number of planes of _QRBitplanes_
+//
+#define QR_BITPLANE_COUNT 3
+
+//------------------------------------------------------------------------------
+///
+/// Position of the zigzag walk that places the data bits into the matrix
+//
+struct _ModuleCursor_
+{
+  int16_t row_;
+  int16_t col_;
+  int8_t row_direction_;
+  bool next_row_;
+};
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the value of a module of the packed rows \p plane
+/// 
+/// @param plane The rows to use
+/// @param row The module row
+/// @param col The module column
+///
+/// @return uint8_t 1 or 0
+//
+static inline uint8_t getPlaneModule(
+const uint64_t (*plane)[QR_MATRIX_ROW_WORDS], uint8_t row, uint8_t col)
+{
+  return (plane[row][col / 64] >> (col % 64)) & 1;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Sets the value of a module of the packed rows \p plane
+/// 
+/// @param plane The rows to use
+/// @param row The module row
+/// @param col The module column
+/// @param value 1 or zero (in fact, everything other than zero is treated as 1)
+//
+static inline void setPlaneModule(uint64_t (*plane)[QR_MATRIX_ROW_WORDS], 
+uint8_t row, uint8_t col, uint8_t value)
+{
+  const uint64_t bit = (uint64_t)1 << (col % 64);
+
+  if (value) plane[row][col / 64] |= bit;
+  else plane[row][col / 64] &= ~bit;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the value of a module of a packed \p matrix
+/// 
+/// @param matrix The matrix to use
+/// @param row The module row
+/// @param col The module column
+///
+/// @return uint8_t 1 or 0
+//
+static inline uint8_t getMatrixModule(const struct _QRMatrix_ *matrix, 
+uint8_t row, uint8_t col)
+{
+  return getPlaneModule(matrix->modules_, row, col);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Sets the value of a module of a packed \p matrix
+/// 
+/// @param matrix The matrix to use
+/// @param row The module row
+/// @param col The module column
+/// @param value 1 or zero (in fact, everything other than zero is treated as 1)
+//
+static inline void setMatrixModule(struct _QRMatrix_ *matrix, uint8_t row, 
+uint8_t col, uint8_t value)
+{
+  setPlaneModule(matrix->modules_, row, col, value);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Stores the \p size rows of \p plane as \p matrix, the rows below
+/// are cleared
+/// 
+/// @param[out] matrix The matrix to write
+/// @param plane The rows to store
+/// @param size The matrix size
+//
+static void storeMatrix(struct _QRMatrix_ *matrix, 
+const uint64_t (*plane)[QR_MATRIX_ROW_WORDS], uint8_t size)
+{
+  matrix->size_ = size;
+  memcpy(matrix->modules_, plane, size * sizeof(matrix->modules_[0]));
+  memset(matrix->modules_ + size, 0, 
+    (QR_MAX_MATRIX_SIZE - size) * sizeof(matrix->modules_[0]));
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the bits of word \p word of a matrix row that lie within 
+/// the matrix
+/// 
+/// @param size The matrix size
+/// @param word The word of the row
+///
+/// @return uint64_t The bits of the modules
+//
+static uint64_t getRowWordMask(uint8_t size, uint8_t word)
+{
+  if (size >= (word + 1) * 64) return ~(uint64_t)0;
+  if (size <= word * 64) return 0;
+  return ((uint64_t)1 << (size - word * 64)) - 1;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Splits \p rows into the cleared planes of \p planes
+/// 
+/// @param[out] planes The bitplanes to initialize
+/// @param rows Storage for QR_BITPLANE_COUNT * \p size rows
+/// @param size The matrix size
+//
+static void createBitplanes(struct _QRBitplanes_ *planes, 
+uint64_t (*rows)[QR_MATRIX_ROW_WORDS], uint8_t size)
+{
+  memset(rows, 0, QR_BITPLANE_COUNT * size * sizeof(rows[0]));
+  planes->values_ = rows;
+  planes->function_ = rows + size;
+  planes->data_ = rows + 2 * size;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Sets the value of a function pattern module and marks it in the 
+/// function plane
+/// 
+/// @param planes The bitplanes to use
+/// @param row The module row
+/// @param col The module column
+/// @param value The module value
+//
+static void setFunctionModule(struct _QRBitplanes_ *planes, uint8_t row, 
+uint8_t col, uint8_t value)
+{
+  setPlaneModule(planes->values_, row, col, value);
+  setPlaneModule(planes->function_, row, col, 1);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns if a module is already used by a function pattern
+/// 
+/// @param planes The bitplanes to use
+/// @param row The module row
+/// @param col The module column
+///
+/// @return uint8_t True if taken, else false
+//
+static uint8_t isFunctionModule(const struct _QRBitplanes_ *planes, 
+uint8_t row, uint8_t col)
+{
+  return getPlaneModule(planes->function_, row, col);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the group of the character count lengths of \p version, see
+/// COUNT_LENGTHS
+/// 
+/// @param version The QR-version
+///
+/// @return The index of the group
+//
+static uint8_t getCountGroup(uint8_t version)
+{
+  if (version < MIN_LONG_COUNT_VERSION) return 0;
+  return version < MIN_LONGEST_COUNT_VERSION ? 1 : 2;
+}
+
+//------------------------------------------------------------------------------
+/// Masks of the highest and the lowest bit of every byte of a 64 bit word
+//
+static const uint64_t BYTE_HIGH_BITS = 0x8080808080808080ULL;
+static const uint64_t BYTE_LOW_BITS = 0x0101010101010101ULL;
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the bytes of \p word within \p first to \p last, which must
+/// be below 0x80
+/// 
+/// @param word 8 bytes, see classifyCharacters
+/// @param first The first byte value within the range
+/// @param last The last byte value within the range
+///
+/// @return The highest bit of every byte within the range
+//
+static inline uint64_t getByteRangeMask(uint64_t word, uint8_t first, 
+uint8_t last)
+{
+  // the set highest bits stop the borrows of the subtractions
+  const uint64_t low_bits = (word & ~BYTE_HIGH_BITS) | BYTE_HIGH_BITS;
+  const uint64_t at_least_first = low_bits - first * BYTE_LOW_BITS;
+  const uint64_t above_last = low_bits - (last + 1) * BYTE_LOW_BITS;
+
+  return at_least_first & ~above_last & ~word & BYTE_HIGH_BITS;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Packs the highest bits of the bytes of \p mask into 8 bits
+/// 
+/// @param mask A byte mask, see getByteRangeMask
+///
+/// @return Bit i is the highest bit of byte i
+//
+static inline uint64_t gatherByteMask(uint64_t mask)
+{
+  return ((mask >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns if the 2 bytes at \p bytes are a Kanji character
+/// 
+/// @param bytes The first byte of the character
+///
+/// @return True if the character fits into Kanji mode
+//
+static inline bool isKanjiCharacter(const unsigned char *bytes)
+{
+  const uint16_t character = (uint16_t)(bytes[0] << 8) | bytes[1];
+
+  // the second byte of a Shift JIS character is 0x40 to 0xFC without 0x7F
+  if (bytes[1] < 0x40 || bytes[1] > 0xFC || bytes[1] == 0x7F) return false;
+  return (character >= 0x8140 && character <= 0x9FFC) || 
+    (character >= 0xE040 && character <= 0xEBBF);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Classifies the bytes of \p payload 8 at once. The bytes are loaded
+/// into a 64 bit word and compared to the ranges of the numeric and 
+/// alphanumeric characters at once, see getByteRangeMask.
+/// 
+/// @param[out] classes The classes of the bytes
+/// @param payload The message to classify
+/// @param len The message length in bytes, at most QR_MAX_INPUT_SIZE
+/// @param kanji Whether to look for Kanji characters
+//
+static void classifyCharacters(struct _CharacterClasses_ *classes, 
+const unsigned char *payload, uint16_t len, bool kanji)
+{
+  const size_t mask_size = CHARACTER_CLASS_WORDS(len) * sizeof(uint64_t);
+
+  memset(classes->numeric_, 0, mask_size);
+  memset(classes->alphanumeric_, 0, mask_size);
+  memset(classes->kanji_, 0, mask_size);
+
+  for (uint16_t position = 0; position < len; position += 8)
+  {
+    const uint16_t word_index = position / 64;
+    const uint8_t shift = position % 64;
+    uint64_t word = 0, numeric, alphanumeric;
+
+    // the bytes behind the payload are 0 and fit into no class
+    for (uint8_t byte = 0; byte < 8 && position + byte < len; byte++)
+    {
+      word |= (uint64_t)payload[position + byte] << (8 * byte);
+    }
+
+    numeric = getByteRangeMask(word, '0', '9');
+    // 0-9 A-Z space $ % * + - . / :
+    alphanumeric = getByteRangeMask(word, '-', ':') | 
+      getByteRangeMask(word, 'A', 'Z') | getByteRangeMask(word, ' ', ' ') | 
+      getByteRangeMask(word, '$', '%') | getByteRangeMask(word, '*', '+');
+
+    classes->numeric_[word_index] |= gatherByteMask(numeric) << shift;
+    classes->alphanumeric_[word_index] |= gatherByteMask(alphanumeric) << shift;
+
+    // Kanji characters start with a byte from 0x81 on
+    if (!kanji || (word & BYTE_HIGH_BITS) == 0) continue;
+    for (uint8_t byte = 0; byte < 8 && position + byte + 1 < len; byte++)
+    {
+      if (isKanjiCharacter(payload + position + byte))
+      {
+        classes->kanji_[word_index] |= (uint64_t)1 << (shift + byte);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the segment modes the character at \p position fits into
+/// 
+/// @param classes The classes of the payload bytes
+/// @param position The index of the first byte of the character
+///
+/// @return Bit i is set if the character fits into segment mode i
+//
+static inline uint8_t getSegmentModes(const struct _CharacterClasses_ *classes,
+uint16_t position)
+{
+  const uint16_t word = position / 64;
+  const uint8_t shift = position % 64;
+
+  return ((classes->numeric_[word] >> shift) & 1) << SEGMENT_NUMERIC | 
+    ((classes->alphanumeric_[word] >> shift) & 1) << SEGMENT_ALPHANUMERIC | 
+    1 << SEGMENT_BYTE | 
+    ((classes->kanji_[word] >> shift) & 1) << SEGMENT_KANJI;
+}
+
+//------------------------------------------------------------------------------
+/// A segmentation step holds the state every segment mode starts from after 
+/// a byte, see segmentPayload. It is the state of the previous character for
+/// a continued segment.
+//
+#define SEGMENT_STEP_BITS 3
+#define SEGMENT_STEP_STATE_MASK 0x07
+
+//------------------------------------------------------------------------------
+/// Cost of the states a position cannot end in, small enough to add the bits
+/// of every further character
+//
+#define SEGMENT_COST_UNREACHABLE (UINT32_MAX / 2)
+
+//------------------------------------------------------------------------------
+///
+/// @brief Keeps the cheaper one of two states
+/// 
+/// @param[in,out] cost The cost of the kept state
+/// @param[in,out] state The kept state
+/// @param other_cost The cost of the other state
+/// @param other The other state
+//
+static inline void keepCheaperState(uint32_t *cost, uint8_t *state, 
+uint32_t other_cost, uint8_t other)
+{
+  if (other_cost < *cost)
+  {
+    *cost = other_cost;
+    *state = other;
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Finds the segments with the fewest bits for the versions of the 
+/// count group \p group. The bytes are encoded one after another, the cost 
+/// of every state after a byte is the cheaper one of continuing the segment
+/// of the previous character and of starting a new segment after the 
+/// cheapest state of another mode (dynamic programming). Kanji characters 
+/// span 2 bytes, so they follow the states before the previous byte. The 
+/// costs stay in registers, only the steps are stored.
+/// 
+/// @param classes The classes of the payload bytes, see classifyCharacters
+/// @param len The message length in bytes, at least 1
+/// @param group The count group, see getCountGroup
+/// @param[out] steps An array of len + 1 elements, element i + 1 is set to 
+/// the state of byte i
+///
+/// @return The length of the segments in bits
+//
+static uint32_t segmentPayload(const struct _CharacterClasses_ *classes, 
+uint16_t len, uint8_t group, uint16_t *steps)
+{
+  const uint32_t unreachable = SEGMENT_COST_UNREACHABLE;
+  uint32_t headers[SEGMENT_MODE_COUNT];
+  // the costs of the states after the previous byte, before the first byte
+  // only a new segment is possible
+  uint32_t numeric_1 = unreachable, numeric_2 = unreachable;
+  uint32_t numeric_3 = unreachable, alphanumeric_1 = unreachable;
+  uint32_t alphanumeric_2 = unreachable, byte = unreachable;
+  uint32_t kanji = unreachable, start = 0;
+  // the Kanji state and the cheapest other state before the previous byte
+  uint32_t kanji_before = unreachable, kanji_switch = unreachable;
+  uint8_t kanji_switch_state = NO_SEGMENT_STATE;
+  // the modes of the last 2 characters, see getSegmentModes
+  uint8_t modes = 0;
+  uint16_t position;
+  uint8_t state;
+
+  for (uint8_t mode = 0; mode < SEGMENT_MODE_COUNT; mode++)
+  {
+    headers[mode] = MODE_INDICATOR_LENGTH + COUNT_LENGTHS[mode][group];
+  }
+
+  for (position = 1; position <= len; position++)
+  {
+    // the cheapest numeric, alphanumeric and other state
+    uint32_t numeric = numeric_1, alphanumeric = alphanumeric_1;
+    uint32_t other = kanji, cost;
+    uint8_t numeric_state = SEGMENT_STATE_NUMERIC_1;
+    uint8_t alphanumeric_state = SEGMENT_STATE_ALPHANUMERIC_1;
+    uint8_t other_state = SEGMENT_STATE_KANJI, origin;
+    uint16_t step;
+
+    modes = (uint8_t)(modes << SEGMENT_MODE_COUNT) | 
+      getSegmentModes(classes, position - 1);
+
+    keepCheaperState(&numeric, &numeric_state, numeric_2, 
+      SEGMENT_STATE_NUMERIC_2);
+    keepCheaperState(&numeric, &numeric_state, numeric_3, 
+      SEGMENT_STATE_NUMERIC_3);
+    keepCheaperState(&alphanumeric, &alphanumeric_state, alphanumeric_2, 
+      SEGMENT_STATE_ALPHANUMERIC_2);
+    keepCheaperState(&other, &other_state, start, NO_SEGMENT_STATE);
+
+    // a numeric segment continues after 3 digits or starts
+    cost = numeric_3;
+    origin = SEGMENT_STATE_NUMERIC_3;
+    keepCheaperState(&cost, &origin, alphanumeric + 
+      headers[SEGMENT_NUMERIC], alphanumeric_state);
+    keepCheaperState(&cost, &origin, byte + headers[SEGMENT_NUMERIC], 
+      SEGMENT_STATE_BYTE);
+    keepCheaperState(&cost, &origin, other + headers[SEGMENT_NUMERIC], 
+      other_state);
+    step = origin << (SEGMENT_STEP_BITS * SEGMENT_NUMERIC);
+    const uint32_t next_numeric_1 = cost + 
+      SEGMENT_STATE_BITS[SEGMENT_STATE_NUMERIC_1];
+
+    // an alphanumeric segment continues after 2 characters or starts
+    cost = alphanumeric_2;
+    origin = SEGMENT_STATE_ALPHANUMERIC_2;
+    keepCheaperState(&cost, &origin, numeric + 
+      headers[SEGMENT_ALPHANUMERIC], numeric_state);
+    keepCheaperState(&cost, &origin, byte + headers[SEGMENT_ALPHANUMERIC], 
+      SEGMENT_STATE_BYTE);
+    keepCheaperState(&cost, &origin, other + headers[SEGMENT_ALPHANUMERIC], 
+      other_state);
+    step |= origin << (SEGMENT_STEP_BITS * SEGMENT_ALPHANUMERIC);
+    const uint32_t next_alphanumeric_1 = cost + 
+      SEGMENT_STATE_BITS[SEGMENT_STATE_ALPHANUMERIC_1];
+
+    // a byte segment continues or starts
+    cost = byte;
+    origin = SEGMENT_STATE_BYTE;
+    keepCheaperState(&cost, &origin, numeric + headers[SEGMENT_BYTE], 
+      numeric_state);
+    keepCheaperState(&cost, &origin, alphanumeric + headers[SEGMENT_BYTE], 
+      alphanumeric_state);
+    keepCheaperState(&cost, &origin, other + headers[SEGMENT_BYTE], 
+      other_state);
+    step |= origin << (SEGMENT_STEP_BITS * SEGMENT_BYTE);
+    const uint32_t next_byte = cost + SEGMENT_STATE_BITS[SEGMENT_STATE_BYTE];
+
+    // a Kanji segment continues or starts before the previous byte
+    cost = kanji_before;
+    origin = SEGMENT_STATE_KANJI;
+    keepCheaperState(&cost, &origin, kanji_switch + headers[SEGMENT_KANJI], 
+      kanji_switch_state);
+    step |= origin << (SEGMENT_STEP_BITS * SEGMENT_KANJI);
+    const uint32_t next_kanji = cost + 
+      SEGMENT_STATE_BITS[SEGMENT_STATE_KANJI];
+
+    // the cheapest state a Kanji character of the next 2 bytes starts after
+    kanji_before = kanji;
+    kanji_switch = numeric;
+    kanji_switch_state = numeric_state;
+    keepCheaperState(&kanji_switch, &kanji_switch_state, alphanumeric, 
+      alphanumeric_state);
+    keepCheaperState(&kanji_switch, &kanji_switch_state, byte, 
+      SEGMENT_STATE_BYTE);
+    keepCheaperState(&kanji_switch, &kanji_switch_state, start, 
+      NO_SEGMENT_STATE);
+
+    // the states of the modes the character does not fit into are dropped, 
+    // a Kanji character starts with the previous byte
+    const bool is_numeric = (modes >> SEGMENT_NUMERIC) & 1;
+    const bool is_alphanumeric = (modes >> SEGMENT_ALPHANUMERIC) & 1;
+    const bool is_kanji = (modes >> (SEGMENT_MODE_COUNT + SEGMENT_KANJI)) & 1;
+
+    numeric_3 = is_numeric ? numeric_2 + 
+      SEGMENT_STATE_BITS[SEGMENT_STATE_NUMERIC_3] : unreachable;
+    numeric_2 = is_numeric ? numeric_1 + 
+      SEGMENT_STATE_BITS[SEGMENT_STATE_NUMERIC_2] : unreachable;
+    numeric_1 = is_numeric ? next_numeric_1 : unreachable;
+    alphanumeric_2 = is_alphanumeric ? alphanumeric_1 + 
+      SEGMENT_STATE_BITS[SEGMENT_STATE_ALPHANUMERIC_2] : unreachable;
+    alphanumeric_1 = is_alphanumeric ? next_alphanumeric_1 : unreachable;
+    byte = next_byte;
+    kanji = is_kanji ? next_kanji : unreachable;
+    start = unreachable;
+
+    steps[position] = step;
+  }
+
+  // byte mode always fits, so the message ends in a reachable state
+  uint32_t length = numeric_1;
+  state = SEGMENT_STATE_NUMERIC_1;
+  keepCheaperState(&length, &state, numeric_2, SEGMENT_STATE_NUMERIC_2);
+  keepCheaperState(&length, &state, numeric_3, SEGMENT_STATE_NUMERIC_3);
+  keepCheaperState(&length, &state, alphanumeric_1, 
+    SEGMENT_STATE_ALPHANUMERIC_1);
+  keepCheaperState(&length, &state, alphanumeric_2, 
+    SEGMENT_STATE_ALPHANUMERIC_2);
+  keepCheaperState(&length, &state, byte, SEGMENT_STATE_BYTE);
+  keepCheaperState(&length, &state, kanji, SEGMENT_STATE_KANJI);
+
+  // follow the steps back, every position is overwritten with its state
+  for (position = len; position > 0;)
+  {
+    const uint8_t mode = SEGMENT_STATE_MODES[state];
+    const uint8_t width = mode == SEGMENT_KANJI ? 2 : 1;
+    uint8_t origin = SEGMENT_STATE_PREVIOUS[state];
+
+    if (SEGMENT_FIRST_STATES[mode] == state)
+    {
+      origin = (steps[position] >> (SEGMENT_STEP_BITS * mode)) & 
+        SEGMENT_STEP_STATE_MASK;
+    }
+    for (uint8_t offset = 0; offset < width; offset++) 
+    {
+      steps[position - offset] = state;
+    }
+    position -= width;
+    state = origin;
+  }
+  return length;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the value of an alphanumeric character
+/// 
+/// @param character 0-9, A-Z, space, $, %, *, +, -, ., / or :
+///
+/// @return The value, 0 to 44
+//
+static uint8_t getAlphanumericValue(unsigned char character)
+{
+  static const char SPECIAL_CHARACTERS[] = " $%*+-./:";
+
+  if (character >= '0' && character <= '9') return character - '0';
+  if (character >= 'A' && character <= 'Z') return character - 'A' + 10;
+  return 36 + (uint8_t)(strchr(SPECIAL_CHARACTERS, character) - 
+    SPECIAL_CHARACTERS);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief A big endian bitstream, the bits are collected in an accumulator 
+/// and written a whole 64 bit word at a time
+//
+struct _BitStream_
+{
+  // the next byte to write
+  uint8_t *next_;
+  // the pending bits in the lowest bits, the earliest highest
+  uint64_t accumulator_;
+  // the number of pending bits, less than 64
+  uint8_t pending_;
+};
+
+//------------------------------------------------------------------------------
+///
+/// @brief Loads 8 bytes as 64 bit big endian number
+/// 
+/// @param bytes The bytes to load
+///
+/// @return The number, the first byte highest
+//
+static inline uint64_t loadBigEndianWord(const unsigned char *bytes)
+{
+  uint64_t word = 0;
+
+  for (uint8_t byte = 0; byte < 8; byte++) word = (word << 8) | bytes[byte];
+  return word;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Stores the highest \p count bytes of \p word, the highest first
+/// 
+/// @param[out] bytes The bytes to write to
+/// @param word The word to store
+/// @param count The number of bytes, at most 8
+//
+static inline void storeBigEndianWord(uint8_t *bytes, uint64_t word, 
+uint8_t count)
+{
+  for (uint8_t byte = 0; byte < count; byte++) 
+  {
+    bytes[byte] = word >> (56 - 8 * byte);
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Appends the lowest \p length bits of \p value to \p stream, the 
+/// highest bit first. A full accumulator is written as a whole word.
+/// 
+/// @param[in,out] stream The stream to append to
+/// @param value The bits to append, the bits above \p length are zero
+/// @param length The number of bits, at most 64
+//
+static inline void appendBits(struct _BitStream_ *stream, uint64_t value, 
+uint8_t length)
+{
+  const uint8_t free_bits = 64 - stream->pending_;
+
+  if (length < free_bits)
+  {
+    stream->accumulator_ = (stream->accumulator_ << length) | value;
+    stream->pending_ += length;
+    return;
+  }
+
+  // the word is completed by the highest free_bits bits of value
+  stream->pending_ = length - free_bits;
+  storeBigEndianWord(stream->next_, free_bits == 64 ? value : 
+    (stream->accumulator_ << free_bits) | (value >> stream->pending_), 8);
+  stream->next_ += 8;
+  stream->accumulator_ = value;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Writes the pending bits of \p stream, the last byte is filled with 
+/// zeros
+/// 
+/// @param[in,out] stream The stream to flush
+///
+/// @return The end of the written bytes
+//
+static inline uint8_t *flushBits(struct _BitStream_ *stream)
+{
+  if (stream->pending_ > 0)
+  {
+    storeBigEndianWord(stream->next_, 
+      stream->accumulator_ << (64 - stream->pending_), 
+      (stream->pending_ + 7) / 8);
+    stream->next_ += (stream->pending_ + 7) / 8;
+    stream->pending_ = 0;
+  }
+  return stream->next_;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Appends a segment of \p len bytes of \p data to \p stream
+/// 
+/// @param[in,out] stream The stream to append to
+/// @param mode The segment mode
+/// @param group The count group of the QR-version, see getCountGroup
+/// @param data The bytes of the segment
+/// @param len The number of bytes, Kanji characters count twice
+//
+static void appendSegment(struct _BitStream_ *stream, uint8_t mode, 
+uint8_t group, const unsigned char *data, uint16_t len)
+{
+  uint16_t counter = 0;
+
+  appendBits(stream, 
+    (uint64_t)SEGMENT_MODE_INDICATORS[mode] << COUNT_LENGTHS[mode][group] | 
+    (mode == SEGMENT_KANJI ? len / 2 : len), 
+    MODE_INDICATOR_LENGTH + COUNT_LENGTHS[mode][group]);
+
+  switch (mode) {
+    case SEGMENT_NUMERIC:
+      // 3 digits in 10 bits, the last 1 or 2 in 4 or 7 bits
+      for (; counter + 3 <= len; counter += 3)
+      {
+        appendBits(stream, (data[counter] - '0') * 100 + 
+          (data[counter + 1] - '0') * 10 + data[counter + 2] - '0', 10);
+      }
+      if (len - counter == 2)
+      {
+        appendBits(stream, (data[counter] - '0') * 10 + 
+          data[counter + 1] - '0', 7);
+      }
+      else if (len - counter == 1)
+      {
+        appendBits(stream, data[counter] - '0', 4);
+      }
+      break;
+    case SEGMENT_ALPHANUMERIC:
+      // 2 characters in 11 bits, the last one in 6 bits
+      for (; counter + 2 <= len; counter += 2)
+      {
+        appendBits(stream, getAlphanumericValue(data[counter]) * 45 + 
+          getAlphanumericValue(data[counter + 1]), 11);
+      }
+      if (counter < len)
+      {
+        appendBits(stream, getAlphanumericValue(data[counter]), 6);
+      }
+      break;
+    case SEGMENT_KANJI:
+      // the character minus 0x8140 or 0xC140, the high byte times 0xC0 plus
+      // the low byte in 13 bits
+      for (; counter < len; counter += 2)
+      {
+        uint16_t character = (uint16_t)(data[counter] << 8) | 
+          data[counter + 1];
+        character -= character <= 0x9FFC ? 0x8140 : 0xC140;
+        appendBits(stream, (character >> 8) * 0xC0 + (character & 0xFF), 13);
+      }
+      break;
+    default:
+      // a memcpy shifted by the pending bits, 8 bytes at a time
+      for (; counter + 8 <= len; counter += 8)
+      {
+        appendBits(stream, loadBigEndianWord(data + counter), 64);
+      }
+      for (; counter < len; counter++)
+      {
+        appendBits(stream, data[counter], 8);
+      }
+      break;
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Converts the _MessageData struct \p md to a byte stream considering
+/// the QR-flavor
+/// 
+/// @param[out] md_stream A preallocated array to write the stream to
+/// @param md The _MessageData struct to convert
+/// @param flavor The QR-flavor to use
+//
+static void generateMessageDataStream(uint8_t *md_stream, 
+struct _MessageData_ *md, struct _QRFlavor_ flavor) 
+{
+  static const uint8_t PADDING[8] = {
+    0xEC, 0x11, 0xEC, 0x11, 0xEC, 0x11, 0xEC, 0x11
+  };
+  const uint8_t group = getCountGroup(flavor.version_);
+  struct _BitStream_ stream = {md_stream, 0, 0};
+  uint8_t *const stream_end = md_stream + flavor.data_codewords_;
+
+  if (md->states_ == NULL)
+  {
+    appendSegment(&stream, SEGMENT_BYTE, group, md->data_, md->data_len_);
+  }
+  else
+  {
+    // a segment ends where the mode of the byte states changes
+    for (uint16_t begin = 0, end; begin < md->data_len_; begin = end)
+    {
+      const uint8_t mode = SEGMENT_STATE_MODES[md->states_[begin + 1]];
+
+      for (end = begin + 1; end < md->data_len_ && 
+        SEGMENT_STATE_MODES[md->states_[end + 1]] == mode; end++);
+      appendSegment(&stream, mode, group, md->data_ + begin, end - begin);
+    }
+  }
+
+  // terminate with up to 4 zeros, the last codeword is filled with zeros
+  const uint32_t position = (stream.next_ - md_stream) * 8 + stream.pending_;
+  const uint32_t capacity = flavor.data_codewords_ * 8;
+  appendBits(&stream, 0, capacity - position < 4 ? capacity - position : 4);
+
+  // padd with 0xEC11
+  uint8_t *padding = flushBits(&stream);
+  for (; stream_end - padding >= 8; padding += 8) memcpy(padding, PADDING, 8);
+  memcpy(padding, PADDING, stream_end - padding);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Creates the position patterns within the \p planes
+/// 
+/// @param planes The bitplanes to use
+/// @param size The matrix size
+//
+static void mkPositionPattern(struct _QRBitplanes_ *planes, uint8_t size) 
+{
+  for (uint8_t row = 0; row < POS_PATTERN_SIZE; row++)
+  {
+    for (uint8_t col = 0; col < POS_PATTERN_SIZE; col++)
+    {
+      const uint8_t value = POS_PATTERN[row][col];
+
+      setFunctionModule(planes, row, col, value);
+      setFunctionModule(planes, row, size - POS_PATTERN_SIZE + col, value);
+      setFunctionModule(planes, size - POS_PATTERN_SIZE + row, col, value);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Creates the separation patterns within the \p planes
+/// 
+/// @param planes The bitplanes to use
+/// @param size The matrix size
+//
+static void mkSeparationPattern(struct _QRBitplanes_ *planes, uint8_t size)
+{
+  // horizontal patterns
+  for (uint8_t col = 0; col < POS_PATTERN_SIZE + 1; col++)
+  {
+    setFunctionModule(planes, POS_PATTERN_SIZE, col, 0);
+    setFunctionModule(planes, POS_PATTERN_SIZE, size - POS_PATTERN_SIZE - 1 + 
+      col, 0);
+    setFunctionModule(planes, size - POS_PATTERN_SIZE - 1, col, 0);
+  }
+
+  // vertical patterns
+  for (uint8_t row = 0; row < POS_PATTERN_SIZE; row++)
+  {
+    setFunctionModule(planes, row, POS_PATTERN_SIZE, 0);
+    setFunctionModule(planes, row, size - POS_PATTERN_SIZE - 1, 0);
+    setFunctionModule(planes, size - POS_PATTERN_SIZE + row, POS_PATTERN_SIZE, 
+      0);
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Creates the alignment patterns within the \p planes, the position 
+/// patterns must already be placed
+/// 
+/// @param planes The bitplanes to use
+/// @param positions The alignment pattern rows and columns, see _QRVersion_
+//
+static void mkAlignmentPatterns(struct _QRBitplanes_ *planes, 
+const uint8_t *positions)
+{
+  for (uint8_t row_it = 0; row_it < QR_MAX_ALIGNMENT_PATTERNS && 
+    positions[row_it]; row_it++)
+  {
+    for (uint8_t col_it = 0; col_it < QR_MAX_ALIGNMENT_PATTERNS && 
+      positions[col_it]; col_it++)
+    {
+      // offset from pattern midpoint
+      const uint8_t row = positions[row_it] - 2;
+      const uint8_t col = positions[col_it] - 2;
+
+      // the corners next to the position patterns stay free
+      if (isFunctionModule(planes, positions[row_it], positions[col_it])) 
+      {
+        continue;
+      }
+      for (uint8_t row_offset = 0; row_offset < ALIGNMENT_PATTERN_SIZE; 
+        row_offset++)
+      {
+        for (uint8_t col_offset = 0; col_offset < ALIGNMENT_PATTERN_SIZE; 
+          col_offset++)
+        {
+          setFunctionModule(planes, row + row_offset, col + col_offset, 
+            ALIGNMENT_PATTERN[row_offset][col_offset]);
+        }
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Creates the sync patterns within the \p planes
+/// 
+/// @param planes The bitplanes to use
+/// @param size The matrix size
+//
+static void mkSyncPattern(struct _QRBitplanes_ *planes, uint8_t size)
+{
+  bool flag = 1;
+  for (uint8_t row_col = POS_PATTERN_SIZE + 1; row_col < size - 1 - 
+    POS_PATTERN_SIZE; row_col++)
+  {
+    // sync row
+    setFunctionModule(planes, SYNC_PATTERN_POS, row_col, flag);
+    // sync column
+    setFunctionModule(planes, row_col, SYNC_PATTERN_POS, flag);
+    flag = !flag;
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Marks the modules used for format- and version string in the 
+/// function plane
+/// 
+/// @param planes The bitplanes to use
+/// @param size The matrix size
+/// @param version_info Whether the matrix has version information
+//
+static void reserveFormatAndVersionModules(struct _QRBitplanes_ *planes, 
+uint8_t size, bool version_info)
+{
+  uint64_t (*function)[QR_MATRIX_ROW_WORDS] = planes->function_;
+
+  for (uint8_t row_col = 0; row_col <= POS_PATTERN_SIZE; row_col++)
+  {
+    // top left vertical and horizontal, the sync patterns cross them
+    setPlaneModule(function, row_col, POS_PATTERN_SIZE + 1, 1);
+    setPlaneModule(function, POS_PATTERN_SIZE + 1, row_col, 1);
+
+    // top right horizontal
+    setPlaneModule(function, POS_PATTERN_SIZE + 1, 
+      size - 1 - POS_PATTERN_SIZE + row_col, 1);
+
+    // bottom left vertical
+    if (row_col == POS_PATTERN_SIZE) continue;
+    setPlaneModule(function, size - POS_PATTERN_SIZE + row_col, 
+      POS_PATTERN_SIZE + 1, 1);
+  }
+
+  // top left corner module
+  setPlaneModule(function, POS_PATTERN_SIZE + 1, POS_PATTERN_SIZE + 1, 1);
+
+  if (!version_info) return;
+
+  // version blocks left of the top right and above the bottom left pattern
+  for (uint8_t bit_pos = 0; bit_pos < VERSION_INFO_LENGTH; bit_pos++)
+  {
+    const uint8_t row = bit_pos / VERSION_INFO_ROWS;
+    const uint8_t col = size - POS_PATTERN_SIZE - 1 - VERSION_INFO_ROWS + 
+      bit_pos % VERSION_INFO_ROWS;
+    setPlaneModule(function, row, col, 1);
+    setPlaneModule(function, col, row, 1);
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Creates all function patterns of \p version within the \p planes,
+/// reserves the modules of the format and version information and marks all
+/// other modules in the data plane
+/// 
+/// @param planes The bitplanes to use, see createBitplanes
+/// @param size The matrix size
+/// @param version The version of the matrix, see _QRVersion_
+//
+static void mkFunctionPatterns(struct _QRBitplanes_ *planes, uint8_t size, 
+const struct _QRVersion_ *version)
+{
+  mkPositionPattern(planes, size);
+
+  mkSeparationPattern(planes, size);
+
+  mkAlignmentPatterns(planes, version->alignment_pattern_pos_);
+
+  mkSyncPattern(planes, size);
+
+  // add fixed black module
+  setFunctionModule(planes, size - POS_PATTERN_SIZE - 1, POS_PATTERN_SIZE + 1,
+    1);
+
+  reserveFormatAndVersionModules(planes, size, version->version_info_ != 0);
+
+  for (uint8_t row = 0; row < size; row++)
+  {
+    for (uint8_t word = 0; word < QR_MATRIX_ROW_WORDS; word++)
+    {
+      planes->data_[row][word] = 
+        ~planes->function_[row][word] & getRowWordMask(size, word);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Moves \p cursor to the next module of the zigzag walk
+/// 
+/// @param cursor The position of the zigzag walk
+/// @param size The matrix size
+//
+static void advanceModuleCursor(struct _ModuleCursor_ *cursor, uint8_t size)
+{
+  if (cursor->next_row_) 
+  {
+    cursor->row_ += cursor->row_direction_;
+    cursor->col_++;
+    // change vertical direction and go to the left
+    if (cursor->row_ < 0 || cursor->row_ >= size) {
+      if (cursor->row_direction_ == UP) cursor->row_direction_ = DOWN;
+      else cursor->row_direction_ = UP;
+      cursor->row_ += cursor->row_direction_;
+      cursor->col_ -= 2;
+      if (cursor->col_ == 6) cursor->col_--;
+    }
+  } 
+  else 
+  {
+    cursor->col_--;
+  }
+  cursor->next_row_ = !cursor->next_row_;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Searches the next module that is not in the function plane
+/// 
+/// @param planes The bitplanes to use
+/// @param size The matrix size
+/// @param cursor The position of the zigzag walk, advanced by this function
+///
+/// @return Returns true if a module is found, its position is \p cursor
+//
+static bool getNextFreeModule(const struct _QRBitplanes_ *planes, uint8_t size,
+struct _ModuleCursor_ *cursor)
+{
+  if (cursor->col_ < 0) cursor->col_ = size - 1;
+  if (cursor->row_ < 0) cursor->row_ = size - 1;
+
+  while (cursor->col_ >= 0) {
+    if (!isFunctionModule(planes, cursor->row_, cursor->col_)) return true;
+    advanceModuleCursor(cursor, size);
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+/// Number of data modules of all versions together, 8 times the sum of their
+/// codewords, see getDataModules
+//
+#define QR_DATA_MODULE_TABLE_SIZE 441456
+
+//------------------------------------------------------------------------------
+/// States of the tables that are built once per version, see 
+/// claimVersionTable
+//
+enum {
+  VERSION_TABLE_EMPTY,
+  VERSION_TABLE_BUILDING,
+  VERSION_TABLE_READY
+};
+
+//------------------------------------------------------------------------------
+///
+/// The data modules of all versions in placement order, version after version.
+/// A module is stored as its bit index row * QR_MATRIX_ROW_BITS + col. The 
+/// modules of a version are built once on first use and are read-only 
+/// afterwards.
+//
+static uint16_t QRDataModules[QR_DATA_MODULE_TABLE_SIZE];
+static _Atomic uint8_t QRDataModuleStates[MAX_QR_VERSION];
+
+//------------------------------------------------------------------------------
+/// Number of times a waiting thread polls a table that is being built before
+/// it yields its time slice, see waitForVersionTable
+//
+#define VERSION_TABLE_SPINS 64
+
+//------------------------------------------------------------------------------
+///
+/// @brief Waits until the table of a version is built by another thread. The
+/// building takes a few microseconds, so the state is polled with a CPU pause
+/// first; after VERSION_TABLE_SPINS polls the builder may be descheduled and 
+/// the time slice is yielded.
+/// 
+/// @param state The state of the table
+//
+static void waitForVersionTable(_Atomic uint8_t *state)
+{
+  for (uint32_t polls = 0; atomic_load_explicit(state, memory_order_acquire) 
+    != VERSION_TABLE_READY; polls++)
+  {
+#if defined(QRC_ENCODE_THREADS)
+    if (polls >= VERSION_TABLE_SPINS) 
+    {
+      thrd_yield();
+      continue;
+    }
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_ia32_pause();
+#elif defined(__GNUC__) && defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Claims the table of a version that is built on first use. The 
+/// first caller has to build it and to publish it with publishVersionTable,
+/// the others wait until it is ready; it is safe to call this function from
+/// several threads.
+/// 
+/// @param state The state of the table
+///
+/// @return true if the caller has to build the table
+//
+static bool claimVersionTable(_Atomic uint8_t *state)
+{
+  uint8_t expected = VERSION_TABLE_EMPTY;
+
+  if (atomic_load_explicit(state, memory_order_acquire) == VERSION_TABLE_READY)
+  {
+    return false;
+  }
+
+  if (atomic_compare_exchange_strong(state, &expected, VERSION_TABLE_BUILDING))
+  {
+    return true;
+  }
+
+  // another thread is building it
+  waitForVersionTable(state);
+  return false;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Marks a table claimed by claimVersionTable as built
+/// 
+/// @param state The state of the table
+//
+static void publishVersionTable(_Atomic uint8_t *state)
+{
+  atomic_store_explicit(state, VERSION_TABLE_READY, memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the number of data and error correction codewords of 
+/// \p version, which is the same for all error correction levels
+/// 
+/// @param version The version, 1 to 40
+///
+/// @return The number of codewords
+//
+static uint16_t getVersionCodewords(uint8_t version)
+{
+  // the flavors are ordered by version
+  const struct _QRFlavor_ *flavor = 
+    &(QRFlavors[(version - 1) * (NUMBER_OF_QR_FLAVORS / MAX_QR_VERSION)]);
+
+  return flavor->data_codewords_ + flavor->ec_data_ * flavor->blocks_;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Walks the zigzag path of \p version and stores the module of each
+/// codeword bit
+/// 
+/// @param[out] data_modules The module indices, 8 per codeword
+/// @param version The version, 1 to 40
+//
+static void buildDataModules(uint16_t *data_modules, uint8_t version)
+{
+  const uint8_t size = 21 + 4 * (version - 1);
+  const uint16_t bit_count = 8 * getVersionCodewords(version);
+  uint64_t rows[QR_BITPLANE_COUNT * QR_MAX_MATRIX_SIZE][QR_MATRIX_ROW_WORDS];
+  struct _QRBitplanes_ planes;
+
+  // every symbol starts its zigzag walk in the bottom right corner
+  struct _ModuleCursor_ cursor = {.row_ = -1, .col_ = -1, 
+    .row_direction_ = UP, .next_row_ = false};
+
+  createBitplanes(&planes, rows, size);
+  mkFunctionPatterns(&planes, size, &(QRVersions[version - 1]));
+
+  for (uint16_t bit = 0; bit < bit_count; bit++)
+  {
+    getNextFreeModule(&planes, size, &cursor);
+    data_modules[bit] = cursor.row_ * QR_MATRIX_ROW_BITS + cursor.col_;
+    advanceModuleCursor(&cursor, size);
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the data modules of \p version, see QRDataModules. The 
+/// first call for a version builds them, it is safe to call this function from
+/// several threads.
+/// 
+/// @param version The version, 1 to 40
+///
+/// @return The module index of every codeword bit in placement order
+//
+static const uint16_t *getDataModules(uint8_t version)
+{
+  _Atomic uint8_t *state = &(QRDataModuleStates[version - 1]);
+  uint32_t offset = 0;
+
+  for (uint8_t previous = MIN_QR_VERSION; previous < version; previous++)
+  {
+    offset += 8 * getVersionCodewords(previous);
+  }
+
+  if (claimVersionTable(state))
+  {
+    buildDataModules(QRDataModules + offset, version);
+    publishVersionTable(state);
+  }
+
+  return QRDataModules + offset;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Inserts the interleaved data and ec-data into the value plane, the
+/// remaining modules stay 0
+/// 
+/// @param planes The bitplanes to use, the data modules must still be 0
+/// @param data_modules The data modules of the matrix, see getDataModules
+/// @param codewords The interleaved codewords, see interleaveCodewords
+/// @param codeword_count The number of \p codewords
+//
+static void mkDataPattern(struct _QRBitplanes_ *planes, 
+const uint16_t *data_modules, const uint8_t *codewords, 
+uint16_t codeword_count)
+{
+  // the rows are consecutive, so bit index / 64 is the word of the module
+  uint64_t *words = &(planes->values_[0][0]);
+
+  for (uint16_t codeword = 0; codeword < codeword_count; codeword++)
+  {
+    for (int8_t bit_pos = 7; bit_pos >= 0; bit_pos--)
+    {
+      const uint16_t module = *(data_modules++);
+
+      words[module / 64] |= 
+        (uint64_t)((codewords[codeword] >> bit_pos) & 1) << (module % 64);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Inserts the interleaved data and ec-data into the value plane like
+/// mkDataPattern, walking the zigzag path instead of using the data module 
+/// table
+/// 
+/// @param planes The bitplanes to use, the data modules must still be 0
+/// @param size The matrix size
+/// @param codewords The interleaved codewords, see interleaveCodewords
+/// @param codeword_count The number of \p codewords
+//
+static void walkDataPattern(struct _QRBitplanes_ *planes, uint8_t size,
+const uint8_t *codewords, uint16_t codeword_count)
+{
+  const uint8_t *codeword_end = codewords + codeword_count;
+  uint8_t remaining_bits = 0;
+  uint8_t current = 0;
+  int8_t row_direction = UP;
+
+  // the walk goes up and down the column pairs from the right, the vertical 
+  // timing pattern in column 6 is skipped, see advanceModuleCursor
+  for (int16_t right = size - 1; right > 0; right -= 2)
+  {
+    if (right == 6) right--;
+    for (uint8_t step = 0; step < size; step++)
+    {
+      const uint8_t row = row_direction == UP ? size - 1 - step : step;
+
+      for (int16_t col = right; col >= right - 1; col--)
+      {
+        if (!getPlaneModule(planes->data_, row, col)) continue;
+        if (remaining_bits == 0)
+        {
+          if (codewords == codeword_end) return;
+          current = *(codewords++);
+          remaining_bits = 8;
+        }
+        planes->values_[row][col / 64] |= 
+          (uint64_t)(current >> 7) << (col % 64);
+        current <<= 1;
+        remaining_bits--;
+      }
+    }
+    row_direction = -row_direction;
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns if a module is inverted by a mask pattern
+/// 
+/// @param mask_id The mask pattern, 0 to MASK_PATTERN_COUNT - 1
+/// @param row The module row
+/// @param col The module column
+///
+/// @return 1 if the module is inverted, otherwise 0
+//
+static uint8_t isMaskedModule(uint8_t mask_id, uint16_t row, uint16_t col)
+{
+  switch (mask_id)
+  {
+    case 0: return (row + col) % 2 == 0;
+    case 1: return row % 2 == 0;
+    case 2: return col % 3 == 0;
+    case 3: return (row + col) % 3 == 0;
+    case 4: return (row / 2 + col / 3) % 2 == 0;
+    case 5: return (row * col) % 2 + (row * col) % 3 == 0;
+    case 6: return ((row * col) % 2 + (row * col) % 3) % 2 == 0;
+    default: return ((row + col) % 2 + (row * col) % 3) % 2 == 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns a word of a mask pattern row, the first MASK_PATTERN_PERIOD
+/// modules of the word are repeated
+/// 
+/// @param mask_id The mask pattern
+/// @param row The row
+/// @param word The word of the row
+///
+/// @return uint64_t The inverted modules of the word
+//
+static uint64_t getMaskWord(uint8_t mask_id, uint8_t row, uint8_t word)
+{
+  uint64_t pattern = 0;
+
+  for (uint8_t col = 0; col < MASK_PATTERN_PERIOD; col++)
+  {
+    pattern |= (uint64_t)isMaskedModule(mask_id, row, word * 64 + col) << col;
+  }
+  pattern |= pattern << 6;
+  pattern |= pattern << 12;
+  pattern |= pattern << 24;
+  pattern |= pattern << 48;
+  return pattern;
+}
+
+//------------------------------------------------------------------------------
+/// Number of rows of all versions together, see QRMaskPlanes
+//
+#define QR_MASK_PLANE_ROWS 3960
+
+//------------------------------------------------------------------------------
+///
+/// The mask patterns of all versions, version after version. A version has 
+/// MASK_PATTERN_COUNT planes of its matrix size rows, the patterns are ANDed 
+/// with the data modules, so a mask is applied by XORing whole rows. The 
+/// planes of a version are built once on first use and are read-only 
+/// afterwards.
+//
+static uint64_t QRMaskPlanes[MASK_PATTERN_COUNT * QR_MASK_PLANE_ROWS]
+  [QR_MATRIX_ROW_WORDS];
+static _Atomic uint8_t QRMaskPlaneStates[MAX_QR_VERSION];
+
+//------------------------------------------------------------------------------
+///
+/// @brief Computes the mask planes of \p version, see QRMaskPlanes
+/// 
+/// @param[out] mask_planes The MASK_PATTERN_COUNT planes of the version
+/// @param version The version, 1 to 40
+//
+static void buildMaskPlanes(uint64_t (*mask_planes)[QR_MATRIX_ROW_WORDS], 
+uint8_t version)
+{
+  const uint8_t size = 21 + 4 * (version - 1);
+  uint64_t rows[QR_BITPLANE_COUNT * QR_MAX_MATRIX_SIZE][QR_MATRIX_ROW_WORDS];
+  struct _QRBitplanes_ planes;
+
+  createBitplanes(&planes, rows, size);
+  mkFunctionPatterns(&planes, size, &(QRVersions[version - 1]));
+
+  for (uint8_t mask_id = 0; mask_id < MASK_PATTERN_COUNT; mask_id++)
+  {
+    for (uint8_t row = 0; row < size; row++)
+    {
+      for (uint8_t word = 0; word < QR_MATRIX_ROW_WORDS; word++)
+      {
+        mask_planes[mask_id * size + row][word] = 
+          getMaskWord(mask_id, row, word) & planes.data_[row][word];
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the mask planes of \p version, see QRMaskPlanes. The first
+/// call for a version builds them, it is safe to call this function from 
+/// several threads.
+/// 
+/// @param version The version, 1 to 40
+///
+/// @return The rows of mask pattern 0, followed by those of the other patterns
+//
+static const uint64_t (*getMaskPlanes(uint8_t version))[QR_MATRIX_ROW_WORDS]
+{
+  _Atomic uint8_t *state = &(QRMaskPlaneStates[version - 1]);
+  uint32_t offset = 0;
+
+  for (uint8_t previous = MIN_QR_VERSION; previous < version; previous++)
+  {
+    offset += MASK_PATTERN_COUNT * (21 + 4 * (previous - 1));
+  }
+
+  if (claimVersionTable(state))
+  {
+    buildMaskPlanes(QRMaskPlanes + offset, version);
+    publishVersionTable(state);
+  }
+
+  return (const uint64_t (*)[QR_MATRIX_ROW_WORDS])(QRMaskPlanes + offset);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Masks the modules of the data plane with a mask pattern
+/// 
+/// @param planes The bitplanes to use
+/// @param size The matrix size
+/// @param mask_id The mask pattern
+/// @param mask_planes The mask planes of the version, see getMaskPlanes, or 
+/// NULL to compute the pattern
+/// @param templates The blank symbols of the version and error correction 
+/// level, see getSymbolTemplates, which are ORed into the matrix; NULL if 
+/// \p mask_planes is NULL
+/// @param[out] masked The \p size rows of the value plane with the masked 
+/// data modules
+//
+static void maskData(const struct _QRBitplanes_ *planes, uint8_t size,
+uint8_t mask_id, const uint64_t (*mask_planes)[QR_MATRIX_ROW_WORDS], 
+const uint64_t (*templates)[QR_MATRIX_ROW_WORDS], 
+uint64_t (*masked)[QR_MATRIX_ROW_WORDS])
+{
+  if (mask_planes)
+  {
+    const uint64_t (*mask)[QR_MATRIX_ROW_WORDS] = mask_planes + mask_id * size;
+    const uint64_t (*blank)[QR_MATRIX_ROW_WORDS] = templates + mask_id * size;
+
+    for (uint8_t row = 0; row < size; row++)
+    {
+      for (uint8_t word = 0; word < QR_MATRIX_ROW_WORDS; word++)
+      {
+        masked[row][word] = blank[row][word] |
+          (planes->values_[row][word] ^ mask[row][word]);
+      }
+    }
+    return;
+  }
+
+  for (uint8_t row = 0; row < size; row++)
+  {
+    for (uint8_t word = 0; word < QR_MATRIX_ROW_WORDS; word++)
+    {
+      masked[row][word] = planes->values_[row][word] ^ 
+        (getMaskWord(mask_id, row, word) & planes->data_[row][word]);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the number of set modules of a word
+/// 
+/// @param modules The word
+///
+/// @return The number of modules
+//
+static inline uint32_t countModules(uint64_t modules)
+{
+  modules -= (modules >> 1) & 0x5555555555555555;
+  modules = (modules & 0x3333333333333333) + 
+    ((modules >> 2) & 0x3333333333333333);
+  modules = (modules + (modules >> 4)) & 0x0f0f0f0f0f0f0f0f;
+  return (modules * 0x0101010101010101) >> 56;
+}
+
+//------------------------------------------------------------------------------
+/// Length of a finder like 1011101 pattern and of the light area before or
+/// after it, see getFinderPenalty
+//
+#define FINDER_PATTERN_LENGTH 7
+#define FINDER_LIGHT_LENGTH 4
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the N1 penalty of the runs of equal modules. A run of
+/// n >= 5 modules has n - 4 windows of 5 and n - 5 windows of 6 equal
+/// modules, so it scores PENALTY_N1 + n - 5.
+///
+/// @param lines 6 successive lines, bit i of lines[k] is module i + k of a
+/// row or module i of the row k below
+/// @param run5_mask The positions a run of 5 may start at
+/// @param run6_mask The positions a run of 6 may start at
+///
+/// @return The penalty
+//
+static inline uint32_t getRunPenalty(const uint64_t *lines, uint64_t run5_mask,
+uint64_t run6_mask)
+{
+  const uint64_t run5 = ~(lines[0] ^ lines[1]) & ~(lines[1] ^ lines[2]) &
+    ~(lines[2] ^ lines[3]) & ~(lines[3] ^ lines[4]) & run5_mask;
+  const uint64_t run6 = run5 & ~(lines[4] ^ lines[5]) & run6_mask;
+
+  return PENALTY_N1 * countModules(run5) -
+    (PENALTY_N1 - 1) * countModules(run6);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the positions of the 1011101 cores of finder like patterns
+///
+/// @param lines FINDER_PATTERN_LENGTH successive lines, see getRunPenalty
+///
+/// @return The positions of the first dark modules
+//
+static inline uint64_t getFinderCores(const uint64_t *lines)
+{
+  return lines[0] & ~lines[1] & lines[2] & lines[3] & lines[4] & ~lines[5] &
+    lines[6];
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the N3 penalty of the finder like patterns 10111010000 and
+/// 00001011101. Modules outside of the matrix count as light.
+///
+/// @param cores The cores of the patterns, see getFinderCores
+/// @param dark_before The positions with a dark module within the
+/// FINDER_LIGHT_LENGTH modules before
+/// @param dark_after The positions with a dark module within the
+/// FINDER_LIGHT_LENGTH modules after the core
+///
+/// @return The penalty
+//
+static inline uint32_t getFinderPenalty(uint64_t cores, uint64_t dark_before,
+uint64_t dark_after)
+{
+  return PENALTY_N3 * (countModules(cores & ~dark_before) +
+    countModules(cores & ~dark_after));
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Evaluates a masked symbol with the penalty rules N1 to N4. Every
+/// row word is compared to its shifted copies and to the words of the
+/// following rows, so 64 modules are scored at once in both directions.
+/// Finder like patterns are rare, the light areas are only checked around
+/// their cores.
+///
+/// @param symbol The rows of the masked symbol with the format and version 
+/// information
+/// @param size The matrix size
+///
+/// @return The penalty, the lower the better
+//
+static uint32_t getMaskPenalty(const uint64_t (*symbol)[QR_MATRIX_ROW_WORDS],
+uint8_t size)
+{
+  static const uint64_t light_row[QR_MATRIX_ROW_WORDS];
+  const uint64_t *rows[FINDER_LIGHT_LENGTH + QR_MAX_MATRIX_SIZE +
+    FINDER_PATTERN_LENGTH + FINDER_LIGHT_LENGTH];
+  const uint8_t words = (size + 63) / 64;
+  uint64_t row_masks[QR_MATRIX_ROW_WORDS];
+  uint64_t run5_masks[QR_MATRIX_ROW_WORDS];
+  uint64_t run6_masks[QR_MATRIX_ROW_WORDS];
+  uint64_t block_masks[QR_MATRIX_ROW_WORDS];
+  uint64_t above_right_equal[QR_MATRIX_ROW_WORDS] = {0};
+  uint32_t penalty = 0;
+  uint32_t dark = 0;
+
+  // the rows around the matrix are light
+  for (int16_t line = 0; line < size + FINDER_PATTERN_LENGTH +
+    2 * FINDER_LIGHT_LENGTH; line++)
+  {
+    const int16_t row = line - FINDER_LIGHT_LENGTH;
+    rows[line] = row >= 0 && row < size ? symbol[row] : light_row;
+  }
+  for (uint8_t word = 0; word < words; word++)
+  {
+    row_masks[word] = getRowWordMask(size, word);
+    run5_masks[word] = getRowWordMask(size - 4, word);
+    run6_masks[word] = getRowWordMask(size - 5, word);
+    block_masks[word] = getRowWordMask(size - 1, word);
+  }
+
+  for (uint8_t row = 0; row < size; row++)
+  {
+    const uint64_t **column = rows + FINDER_LIGHT_LENGTH + row;
+    uint64_t padded[QR_MATRIX_ROW_WORDS + 2] = {0};
+
+    memcpy(padded + 1, symbol[row], sizeof(symbol[row]));
+
+    for (uint8_t word = 0; word < words; word++)
+    {
+      const uint64_t previous = padded[word];
+      const uint64_t current = padded[word + 1];
+      const uint64_t next = padded[word + 2];
+      uint64_t lines[FINDER_PATTERN_LENGTH];
+      uint64_t cores;
+
+      // the row, shifted to the modules after the word
+      lines[0] = current;
+      for (uint8_t shift = 1; shift < FINDER_PATTERN_LENGTH; shift++)
+      {
+        lines[shift] = (current >> shift) | (next << (64 - shift));
+      }
+      penalty += getRunPenalty(lines, run5_masks[word], run6_masks[word]);
+      cores = getFinderCores(lines);
+      if (cores)
+      {
+        uint64_t dark_before = 0, dark_after = 0;
+        for (uint8_t shift = 1; shift <= FINDER_LIGHT_LENGTH; shift++)
+        {
+          dark_before |= (current << shift) | (previous >> (64 - shift));
+          dark_after |= (current >> (FINDER_PATTERN_LENGTH - 1 + shift)) |
+            (next << (64 - FINDER_PATTERN_LENGTH + 1 - shift));
+        }
+        penalty += getFinderPenalty(cores, dark_before, dark_after);
+      }
+
+      // 2x2 blocks of equal modules with the row above
+      const uint64_t right_equal = ~(current ^ lines[1]) & block_masks[word];
+      penalty += PENALTY_N2 * countModules(right_equal &
+        above_right_equal[word] & ~(current ^ column[-1][word]));
+      above_right_equal[word] = right_equal;
+
+      // the column from the row on, the rows after the matrix are light
+      for (uint8_t line = 0; line < FINDER_PATTERN_LENGTH; line++)
+      {
+        lines[line] = column[line][word];
+      }
+      penalty += getRunPenalty(lines, row + 4 < size ? row_masks[word] : 0,
+        row + 5 < size ? row_masks[word] : 0);
+      cores = getFinderCores(lines);
+      if (cores)
+      {
+        uint64_t dark_before = 0, dark_after = 0;
+        for (uint8_t line = 1; line <= FINDER_LIGHT_LENGTH; line++)
+        {
+          dark_before |= column[-line][word];
+          dark_after |= column[FINDER_PATTERN_LENGTH - 1 + line][word];
+        }
+        penalty += getFinderPenalty(cores, dark_before, dark_after);
+      }
+
+      dark += countModules(current);
+    }
+  }
+
+  // the number of whole 5% steps the dark modules differ from 50%
+  const uint32_t total = size * size;
+  const uint32_t deviation = 2 * dark > total ? 2 * dark - total :
+    total - 2 * dark;
+  return penalty + PENALTY_N4 * (deviation * 10 / total);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Places the format and version info into the modules reserved by 
+/// reserveFormatAndVersionModules
+/// 
+/// @param plane The rows of the value plane to use
+/// @param size The matrix size
+/// @param format_string The format data
+/// @param version_info The version data, 0 for versions without
+//
+static void mkFormatVersionPattern(uint64_t (*plane)[QR_MATRIX_ROW_WORDS], 
+uint8_t size, uint32_t format_string, uint32_t version_info)
+{
+  uint8_t col, row;
+  for (uint8_t bit_pos = 0; bit_pos < FORMAT_VERSION_LENGTH; bit_pos++)
+  {
+    // first pattern
+    if (bit_pos <= 7)
+    {
+      col = POS_PATTERN_SIZE + 1;
+      row = bit_pos;
+      if (bit_pos >= SYNC_PATTERN_POS) row++;
+    }
+    else 
+    {
+      col = POS_PATTERN_SIZE - (bit_pos - 8);
+      if (col <= SYNC_PATTERN_POS) col--;
+      row = POS_PATTERN_SIZE + 1;
+    }
+    setPlaneModule(plane, row, col, (format_string >> bit_pos) & 1);
+    
+    // second pattern
+    if (bit_pos <= 7)
+    {
+      col = size - 1 - bit_pos;
+      row = POS_PATTERN_SIZE + 1;
+    }
+    else 
+    {
+      col = POS_PATTERN_SIZE + 1;
+      row = size - 1 - 6 + (bit_pos - 8);
+    }
+    setPlaneModule(plane, row, col, (format_string >> bit_pos) & 1);
+  }
+
+  if (!version_info) return;
+
+  // the two version blocks are transposed to each other
+  for (uint8_t bit_pos = 0; bit_pos < VERSION_INFO_LENGTH; bit_pos++)
+  {
+    row = bit_pos / VERSION_INFO_ROWS;
+    col = size - POS_PATTERN_SIZE - 1 - VERSION_INFO_ROWS + 
+      bit_pos % VERSION_INFO_ROWS;
+    setPlaneModule(plane, row, col, (version_info >> bit_pos) & 1);
+    setPlaneModule(plane, col, row, (version_info >> bit_pos) & 1);
+  }
+}
+
+//------------------------------------------------------------------------------
+/// Number of error correction levels, see getECLevelIndex
+//
+#define QR_EC_LEVEL_COUNT 4
+
+//------------------------------------------------------------------------------
+///
+/// The blank symbols of all versions, version after version. A version has a
+/// symbol for every error correction level and mask pattern, ordered by level
+/// and then by mask, of its matrix size rows each. A blank symbol holds the 
+/// function patterns with the format and version information in place and 
+/// no data modules, so a candidate of selectMask is the template ORed with 
+/// its masked data. The symbols of a version are built once on first use and
+/// are read-only afterwards.
+//
+static uint64_t QRSymbolTemplates[QR_EC_LEVEL_COUNT * MASK_PATTERN_COUNT * 
+  QR_MASK_PLANE_ROWS][QR_MATRIX_ROW_WORDS];
+static _Atomic uint8_t QRSymbolTemplateStates[MAX_QR_VERSION];
+
+//------------------------------------------------------------------------------
+///
+/// @brief Builds the blank symbols of \p version, see QRSymbolTemplates
+/// 
+/// @param[out] templates The QR_EC_LEVEL_COUNT * MASK_PATTERN_COUNT symbols 
+/// of the version
+/// @param version The version, 1 to 40
+//
+static void buildSymbolTemplates(uint64_t (*templates)[QR_MATRIX_ROW_WORDS], 
+uint8_t version)
+{
+  const uint8_t size = 21 + 4 * (version - 1);
+  uint64_t rows[QR_BITPLANE_COUNT * QR_MAX_MATRIX_SIZE][QR_MATRIX_ROW_WORDS];
+  struct _QRBitplanes_ planes;
+
+  createBitplanes(&planes, rows, size);
+  mkFunctionPatterns(&planes, size, &(QRVersions[version - 1]));
+
+  for (uint8_t ec_level_index = 0; ec_level_index < QR_EC_LEVEL_COUNT; 
+    ec_level_index++)
+  {
+    for (uint8_t mask_id = 0; mask_id < MASK_PATTERN_COUNT; mask_id++)
+    {
+      uint64_t (*symbol)[QR_MATRIX_ROW_WORDS] = templates + 
+        (ec_level_index * MASK_PATTERN_COUNT + mask_id) * size;
+      uint32_t format_string = 0;
+
+      // valid levels and masks always have a format string
+      generateFormatString(&format_string, MIN_QR_VERSION, ec_level_index, 
+        mask_id);
+      memcpy(symbol, planes.values_, size * sizeof(symbol[0]));
+      mkFormatVersionPattern(symbol, size, format_string, 
+        QRVersions[version - 1].version_info_);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the blank symbols of \p version for an error correction 
+/// level, see QRSymbolTemplates. The first call for a version builds them, it
+/// is safe to call this function from several threads.
+/// 
+/// @param version The version, 1 to 40
+/// @param ec_level_index The error correction level, see getECLevelIndex
+///
+/// @return The rows of the symbol of mask pattern 0, followed by those of the
+/// other patterns
+//
+static const uint64_t (*getSymbolTemplates(uint8_t version, 
+uint8_t ec_level_index))[QR_MATRIX_ROW_WORDS]
+{
+  _Atomic uint8_t *state = &(QRSymbolTemplateStates[version - 1]);
+  const uint8_t size = 21 + 4 * (version - 1);
+  uint32_t offset = 0;
+
+  for (uint8_t previous = MIN_QR_VERSION; previous < version; previous++)
+  {
+    offset += QR_EC_LEVEL_COUNT * MASK_PATTERN_COUNT * 
+      (21 + 4 * (previous - 1));
+  }
+
+  if (claimVersionTable(state))
+  {
+    buildSymbolTemplates(QRSymbolTemplates + offset, version);
+    publishVersionTable(state);
+  }
+
+  return (const uint64_t (*)[QR_MATRIX_ROW_WORDS])(QRSymbolTemplates + offset +
+    ec_level_index * MASK_PATTERN_COUNT * size);
+}
+
+//------------------------------------------------------------------------------
+///
+/// Options of qrEncode
+//
+struct _QROptions_
+{
+  // the minimum error correction level ('L', 'M', 'Q' or 'H'), the most robust
+  // level fitting into the smallest possible version is used; 0 equals 'L'
+  unsigned char ec_level_;
+  // whether to store the matrix before masking in _QRCode_.data_matrix_
+  bool keep_data_matrix_;
+  // whether the payload is Shift JIS text, its double byte characters are 
+  // encoded in Kanji mode then
+  bool kanji_;
+};
+
+//------------------------------------------------------------------------------
+///
+/// Result of qrEncode
+//
+struct _QRCode_
+{
+  uint8_t version_;
+  unsigned char ec_level_;
+  uint8_t mask_id_;
+  uint32_t format_string_;
+  uint16_t data_codewords_;
+  uint16_t ec_codewords_;
+  // the number of blocks, see _QRFlavor_
+  uint8_t blocks_;
+  // the data codewords followed by the error correction codewords, both 
+  // block after block, see interleaveCodewords
+  uint8_t codewords_[QR_MAX_CODEWORDS];
+  struct _QRMatrix_ matrix_;
+  struct _QRMatrix_ data_matrix_;
+};
+
+//------------------------------------------------------------------------------
+///
+/// @brief Converts the error correction level to the value used in the format
+/// string
+/// 
+/// @param ec_level The error correction level 'L', 'M', 'Q' or 'H'
+///
+/// @return 0 to 3, -1 for invalid levels
+//
+static int getECLevelIndex(unsigned char ec_level)
+{
+  switch (ec_level) {
+    case 'L':
+      return 0;
+    case 'M':
+      return 1;
+    case 'Q':
+      return 2;
+    case 'H':
+      return 3;
+    default:
+      return -1;
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Selects the smallest QR-version of the count group \p group which
+/// can hold \p length bits with at least the error correction level 
+/// \p ec_level, and within it the most robust level that still fits
+/// 
+/// @param[out] flavor The QR-flavor to use
+/// @param length The message length in bits
+/// @param group The count group of the versions to check, see getCountGroup
+/// @param ec_level The minimum error correction level
+///
+/// @return QR_ENCODE_RETURN_SUCCESSFUL or QR_ENCODE_ERROR_DATA_TOO_LONG if no
+/// flavor is big enough
+//
+static int selectFlavor(struct _QRFlavor_ *flavor, uint32_t length, 
+uint8_t group, unsigned char ec_level)
+{
+  // the levels are ordered L, M, Q, H, see getECLevelIndex
+  const int min_level = getECLevelIndex(ec_level);
+
+  for (uint8_t counter = 0; counter < NUMBER_OF_QR_FLAVORS; counter++) 
+  {
+    if (getCountGroup(QRFlavors[counter].version_) != group) continue;
+    if (QRFlavors[counter].data_codewords_ * 8 < length) continue;
+    if (getECLevelIndex(QRFlavors[counter].ec_level_) < min_level) continue;
+    *flavor = QRFlavors[counter];
+    return QR_ENCODE_RETURN_SUCCESSFUL;
+  }
+  return QR_ENCODE_ERROR_DATA_TOO_LONG;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Converts the return constants of qrc_ecc.h to the ones of this
+/// library
+/// 
+/// @param return_value The return value of an ecc function
+///
+/// @return The matching QR_ENCODE_ return constant
+//
+static int convertECCReturnValue(int return_value)
+{
+  switch (return_value) {
+    case ERROR_CORRECTION_RETURN_SUCCESSFUL:
+      return QR_ENCODE_RETURN_SUCCESSFUL;
+    case ERROR_CORRECTION_ERROR_OUT_OF_MEMORY:
+      return QR_ENCODE_ERROR_OUT_OF_MEMORY;
+    default:
+      return QR_ENCODE_ERROR_INVALID_PARAMETER;
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// Options used if qrEncode or qrEncodeBatch are called without options
+//
+static const struct _QROptions_ QR_DEFAULT_OPTIONS = {.ec_level_ = 'L', 
+  .keep_data_matrix_ = false};
+
+//------------------------------------------------------------------------------
+/// Rounds a buffer size up to whole 64 bit words
+//
+#define QR_WORKSPACE_ALIGN(size) (((size) + 7) / 8 * 8)
+
+//------------------------------------------------------------------------------
+/// Size of the working buffers of the segmentation of a payload of \p len 
+/// bytes: the character class masks followed by the states of the bytes, see
+/// prepareQRCode
+//
+#define QR_SEGMENT_WORKSPACE_SIZE(len) \
+  QR_WORKSPACE_ALIGN(CHARACTER_CLASS_COUNT * sizeof(uint64_t) * \
+    CHARACTER_CLASS_WORDS(len) + sizeof(uint16_t) * ((len) + 1))
+
+//------------------------------------------------------------------------------
+///
+/// @brief The first step of qrEncode. Selects the QR-flavor of \p payload and
+/// generates the data codewords into \p out.
+/// 
+/// @param payload The message to encode, it does not need to be terminated
+/// @param len The message length in bytes
+/// @param options The options to use
+/// @param segment_workspace QR_SEGMENT_WORKSPACE_SIZE(\p len) bytes aligned
+/// to 8 bytes to split the message into the segments with the fewest bits 
+/// in, see segmentPayload, or NULL to encode it as a single byte mode segment
+/// @param[out] out The QR-Code to encode into
+/// @param[out] flavor The selected QR-flavor
+///
+/// @return see qrEncode
+//
+static int prepareQRCode(const unsigned char *payload, size_t len, 
+const struct _QROptions_ *options, void *segment_workspace, 
+struct _QRCode_ *out, struct _QRFlavor_ *flavor)
+{
+  struct _MessageData_ MessageData;
+  struct _CharacterClasses_ classes;
+  bool segmented = segment_workspace != NULL;
+  uint16_t *states = NULL;
+  uint32_t length;
+  int return_value = QR_ENCODE_ERROR_DATA_TOO_LONG;
+
+  if ((payload == NULL && len > 0) || out == NULL) 
+  {
+    return QR_ENCODE_ERROR_INVALID_PARAMETER;
+  }
+  if (options->ec_level_ != 0 && getECLevelIndex(options->ec_level_) < 0)
+  {
+    return QR_ENCODE_ERROR_INVALID_PARAMETER;
+  }
+  if (len > QR_MAX_INPUT_SIZE) return QR_ENCODE_ERROR_DATA_TOO_LONG;
+
+  // an empty message stays an empty byte mode segment
+  segmented = segmented && len > 0;
+  if (segmented) 
+  {
+    const size_t words = CHARACTER_CLASS_WORDS(len);
+
+    classes.numeric_ = segment_workspace;
+    classes.alphanumeric_ = classes.numeric_ + words;
+    classes.kanji_ = classes.alphanumeric_ + words;
+    states = (uint16_t *)(classes.kanji_ + words);
+    classifyCharacters(&classes, payload, len, options->kanji_);
+  }
+
+  // the segments of the smaller versions are found first, the states of the
+  // group that fits are kept
+  for (uint8_t group = 0; group < COUNT_GROUPS && 
+    return_value != QR_ENCODE_RETURN_SUCCESSFUL; group++)
+  {
+    length = segmented ? segmentPayload(&classes, len, group, states) :
+      MODE_INDICATOR_LENGTH + COUNT_LENGTHS[SEGMENT_BYTE][group] + 8 * len;
+    return_value = selectFlavor(flavor, length, group, options->ec_level_ ? 
+      options->ec_level_ : 'L');
+  }
+  if (return_value != QR_ENCODE_RETURN_SUCCESSFUL) return return_value;
+
+  out->version_ = flavor->version_;
+  out->ec_level_ = flavor->ec_level_;
+  out->data_codewords_ = flavor->data_codewords_;
+  out->ec_codewords_ = flavor->ec_data_ * flavor->blocks_;
+  out->blocks_ = flavor->blocks_;
+
+  MessageData.data_len_ = len;
+  MessageData.data_ = payload;
+  MessageData.states_ = segmented ? states : NULL;
+
+  // data block
+  generateMessageDataStream(out->codewords_, &MessageData, *flavor);
+
+  return QR_ENCODE_RETURN_SUCCESSFUL;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the position of a data block within the data codewords of 
+/// \p code, the shorter blocks come first
+/// 
+/// @param code The QR-Code to use
+/// @param block The index of the block
+/// @param[out] length The number of data codewords of the block
+///
+/// @return The index of the first data codeword of the block
+//
+static uint16_t getDataBlock(const struct _QRCode_ *code, uint8_t block, 
+uint16_t *length)
+{
+  const uint16_t short_length = code->data_codewords_ / code->blocks_;
+  const uint8_t short_blocks = code->blocks_ - 
+    code->data_codewords_ % code->blocks_;
+
+  *length = short_length + (block >= short_blocks);
+  return block * short_length + 
+    (block > short_blocks ? block - short_blocks : 0);
+}
+
+//------------------------------------------------------------------------------
+/// Min number of blocks from which the blocks of a QR-Code are encoded as 
+/// lanes, see generateLaneErrorCorrection
+//
+#define MIN_LANE_ECC_BLOCKS 8
+
+//------------------------------------------------------------------------------
+///
+/// @brief Generates the error correction codewords of all blocks of \p out at
+/// once, every block is a lane of generateErrorCorrectionCodewordsBatch. The 
+/// shorter blocks are prefixed with a 0 codeword, which leaves their error
+/// correction codewords unchanged. The lanes come out interleaved as in the 
+/// matrix, see interleaveCodewords, and are copied back block after block.
+/// 
+/// @param[in,out] out The QR-Code with the data codewords
+///
+/// @return see qrEncode
+//
+static int generateLaneErrorCorrection(struct _QRCode_ *out)
+{
+  const uint8_t blocks = out->blocks_;
+  const uint16_t ec_length = out->ec_codewords_ / blocks;
+  uint8_t messages[QR_MAX_BLOCK_DATA_CODEWORDS * QR_MAX_BLOCKS];
+  uint8_t ec_data[QR_MAX_EC_CODEWORDS];
+  uint8_t *ec_blocks = out->codewords_ + out->data_codewords_;
+  uint16_t offset, length, message_length;
+  int return_value;
+
+  // the first codeword of the long blocks overwrites the 0 prefix
+  getDataBlock(out, blocks - 1, &message_length);
+  memset(messages, 0, blocks);
+  for (uint8_t block = 0; block < blocks; block++)
+  {
+    offset = getDataBlock(out, block, &length);
+
+    // codeword i of block b is at i * blocks + b
+    for (uint16_t codeword = 0; codeword < length; codeword++)
+    {
+      messages[(message_length - length + codeword) * blocks + block] = 
+        out->codewords_[offset + codeword];
+    }
+  }
+
+  return_value = generateErrorCorrectionCodewordsBatch(ec_data, ec_length, 
+    messages, message_length, blocks);
+  if (return_value != ERROR_CORRECTION_RETURN_SUCCESSFUL) 
+  {
+    return convertECCReturnValue(return_value);
+  }
+
+  for (uint8_t block = 0; block < blocks; block++)
+  {
+    for (uint16_t codeword = 0; codeword < ec_length; codeword++)
+    {
+      ec_blocks[block * ec_length + codeword] = 
+        ec_data[codeword * blocks + block];
+    }
+  }
+  return QR_ENCODE_RETURN_SUCCESSFUL;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief The second step of qrEncode. Generates the error correction 
+/// codewords of every block of \p out, codes with many blocks encode them 
+/// side by side, see generateLaneErrorCorrection.
+/// 
+/// @param[in,out] out The QR-Code with the data codewords
+/// @param ecc_workspace NULL, or the workspace to encode the blocks one after 
+/// another in, see generateErrorCorrectionCodewordsInWorkspace
+///
+/// @return see qrEncode
+//
+static int generateBlockErrorCorrection(struct _QRCode_ *out, 
+uint8_t *ecc_workspace)
+{
+  const uint16_t ec_length = out->ec_codewords_ / out->blocks_;
+  uint16_t offset, length;
+  int return_value;
+
+  if (!ecc_workspace && out->blocks_ >= MIN_LANE_ECC_BLOCKS) 
+  {
+    return generateLaneErrorCorrection(out);
+  }
+
+  // all blocks of a QR-Code share the generator products of the workspace
+  if (ecc_workspace)
+  {
+    return_value = prepareErrorCorrectionWorkspace(ec_length, ecc_workspace);
+    if (return_value != ERROR_CORRECTION_RETURN_SUCCESSFUL) 
+    {
+      return convertECCReturnValue(return_value);
+    }
+  }
+
+  for (uint8_t block = 0; block < out->blocks_; block++)
+  {
+    uint8_t *ec_block = out->codewords_ + out->data_codewords_ + 
+      block * ec_length;
+
+    offset = getDataBlock(out, block, &length);
+    if (ecc_workspace)
+    {
+      return_value = generateErrorCorrectionCodewordsInWorkspace(ec_block, 
+        ec_length, out->codewords_ + offset, length, ecc_workspace);
+    }
+    else
+    {
+      return_value = generateErrorCorrectionCodewords(ec_block, ec_length, 
+        out->codewords_ + offset, length);
+    }
+    if (return_value != ERROR_CORRECTION_RETURN_SUCCESSFUL) 
+    {
+      return convertECCReturnValue(return_value);
+    }
+  }
+  return QR_ENCODE_RETURN_SUCCESSFUL;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Orders the codewords of \p code for the matrix: codeword i of every
+/// data block, then codeword i + 1 of every block and so on, followed by the 
+/// error correction codewords in the same way
+/// 
+/// @param code The QR-Code to use
+/// @param[out] stream A preallocated array for all codewords of \p code
+//
+static void interleaveCodewords(const struct _QRCode_ *code, uint8_t *stream)
+{
+  const uint16_t ec_length = code->ec_codewords_ / code->blocks_;
+  const uint8_t *ec_data = code->codewords_ + code->data_codewords_;
+  uint16_t offsets[QR_MAX_BLOCKS];
+  uint16_t lengths[QR_MAX_BLOCKS];
+  uint16_t position = 0;
+
+  for (uint8_t block = 0; block < code->blocks_; block++)
+  {
+    offsets[block] = getDataBlock(code, block, &(lengths[block]));
+  }
+
+  // the last blocks are one codeword longer
+  for (uint16_t codeword = 0; codeword < lengths[code->blocks_ - 1]; 
+    codeword++)
+  {
+    for (uint8_t block = 0; block < code->blocks_; block++)
+    {
+      if (codeword >= lengths[block]) continue;
+      stream[position++] = code->codewords_[offsets[block] + codeword];
+    }
+  }
+
+  for (uint16_t codeword = 0; codeword < ec_length; codeword++)
+  {
+    for (uint8_t block = 0; block < code->blocks_; block++)
+    {
+      stream[position++] = ec_data[block * ec_length + codeword];
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Masks the symbol with every mask pattern and keeps the one with the
+/// lowest penalty, see getMaskPenalty. The format information depends on the
+/// mask, so every candidate is evaluated with its own.
+/// 
+/// @param[in,out] out The QR-Code, its matrix, mask and format are set
+/// @param planes The bitplanes with the unmasked symbol
+/// @param size The matrix size
+/// @param version The version of \p out
+/// @param ec_level_index The error correction level, see getECLevelIndex
+/// @param mask_planes The mask planes of the version, see maskData
+/// @param templates The blank symbols with the format and version 
+/// information, see maskData; NULL to place the information into every 
+/// candidate
+/// @param candidate Storage for the \p size rows of the masked symbols
+///
+/// @return see qrEncode
+//
+static int selectMask(struct _QRCode_ *out, const struct _QRBitplanes_ *planes,
+uint8_t size, const struct _QRVersion_ *version, uint8_t ec_level_index, 
+const uint64_t (*mask_planes)[QR_MATRIX_ROW_WORDS],
+const uint64_t (*templates)[QR_MATRIX_ROW_WORDS], 
+uint64_t (*candidate)[QR_MATRIX_ROW_WORDS])
+{
+  uint32_t best_penalty = UINT32_MAX;
+  uint32_t format_string;
+  int return_value;
+
+  for (uint8_t mask_id = 0; mask_id < MASK_PATTERN_COUNT; mask_id++)
+  {
+    // the format string is the same for all versions, generateFormatString 
+    // returns the version information from MIN_LONG_INFO_VERSION on
+    return_value = generateFormatString(&format_string, MIN_QR_VERSION, 
+      ec_level_index, mask_id);
+    if (return_value != ERROR_CORRECTION_RETURN_SUCCESSFUL) 
+    {
+      return convertECCReturnValue(return_value);
+    }
+
+    maskData(planes, size, mask_id, mask_planes, templates, candidate);
+    if (!templates) mkFormatVersionPattern(candidate, size, format_string, 
+      version->version_info_);
+
+    const uint32_t penalty = getMaskPenalty(candidate, size);
+    if (penalty < best_penalty)
+    {
+      best_penalty = penalty;
+      storeMatrix(&(out->matrix_), candidate, size);
+      out->mask_id_ = mask_id;
+      out->format_string_ = format_string;
+    }
+  }
+  return QR_ENCODE_RETURN_SUCCESSFUL;
+}
+
+//------------------------------------------------------------------------------
+/// Number of planes mkQRMatrix works in, the bitplanes and the mask candidate
+//
+#define QR_WORK_PLANE_COUNT (QR_BITPLANE_COUNT + 1)
+
+//------------------------------------------------------------------------------
+///
+/// @brief Places the data and error correction codewords of \p out with the
+/// function patterns into its matrix, see finishQRCode
+/// 
+/// @param[in,out] out The QR-Code with all codewords
+/// @param flavor The QR-flavor of \p out
+/// @param options The options to use
+/// @param rows Storage for QR_WORK_PLANE_COUNT planes of the matrix size 
+/// rows, the bitplanes followed by the mask candidate, see selectMask
+/// @param codewords Storage for the interleaved codewords of \p out
+/// @param shared_tables true to use the data modules, mask planes and blank
+/// symbols of the version, see getDataModules, getMaskPlanes and 
+/// getSymbolTemplates, so only the data modules are placed; false to build 
+/// the function patterns, to walk the zigzag path and to compute the mask 
+/// patterns
+///
+/// @return see qrEncode
+//
+static int mkQRMatrix(struct _QRCode_ *out, const struct _QRFlavor_ *flavor,
+const struct _QROptions_ *options, uint64_t (*rows)[QR_MATRIX_ROW_WORDS], 
+uint8_t *codewords, bool shared_tables)
+{
+  const struct _QRVersion_ *version = &(QRVersions[flavor->version_ - 1]);
+  const uint16_t codeword_count = out->data_codewords_ + out->ec_codewords_;
+  const uint8_t ec_level_index = getECLevelIndex(flavor->ec_level_);
+  uint8_t size = 21 + 4 * (flavor->version_ - 1);
+  struct _QRBitplanes_ planes;
+
+  createBitplanes(&planes, rows, size);
+  interleaveCodewords(out, codewords);
+  if (shared_tables)
+  {
+    // the function patterns come with the blank symbols
+    mkDataPattern(&planes, getDataModules(flavor->version_), codewords, 
+      codeword_count);
+    if (options->keep_data_matrix_) 
+    {
+      mkFunctionPatterns(&planes, size, version);
+    }
+  }
+  else
+  {
+    mkFunctionPatterns(&planes, size, version);
+    walkDataPattern(&planes, size, codewords, codeword_count);
+  }
+
+  if (options->keep_data_matrix_) 
+  {
+    storeMatrix(&(out->data_matrix_), planes.values_, size);
+  }
+
+  return selectMask(out, &planes, size, version, ec_level_index, 
+    shared_tables ? getMaskPlanes(flavor->version_) : NULL,
+    shared_tables ? getSymbolTemplates(flavor->version_, ec_level_index) : 
+    NULL, rows + QR_BITPLANE_COUNT * size);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief The last step of qrEncode. Places the data and error correction 
+/// codewords of \p out with the function patterns into its matrix.
+/// 
+/// @param[in,out] out The QR-Code with all codewords
+/// @param flavor The QR-flavor of \p out
+/// @param options The options to use
+///
+/// @return see qrEncode
+//
+static int finishQRCode(struct _QRCode_ *out, const struct _QRFlavor_ *flavor,
+const struct _QROptions_ *options)
+{
+  uint64_t rows[QR_WORK_PLANE_COUNT * QR_MAX_MATRIX_SIZE][QR_MATRIX_ROW_WORDS];
+  uint8_t codewords[QR_MAX_CODEWORDS];
+
+  return mkQRMatrix(out, flavor, options, rows, codewords, true);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief The core function of this library. Encodes \p payload as QR-Code,
+/// the payload is split into the numeric, alphanumeric, byte and Kanji 
+/// segments with the fewest bits.
+/// 
+/// @param payload The message to encode, it does not need to be terminated
+/// @param len The message length in bytes
+/// @param options The options to use, NULL for the defaults
+/// @param[out] out The encoded QR-Code
+///
+/// @return QR_ENCODE_RETURN_SUCCESSFUL if executes successfully,
+///         QR_ENCODE_ERROR_DATA_TOO_LONG if the payload does not fit into any
+///         QR-flavor and QR_ENCODE_ERROR_INVALID_PARAMETER if this function 
+///         is called with invalid parameters
+//
+static inline int qrEncode(const unsigned char *payload, size_t len, 
+const struct _QROptions_ *options, struct _QRCode_ *out)
+{
+  uint64_t segments[QR_SEGMENT_WORKSPACE_SIZE(QR_MAX_INPUT_SIZE) / 
+    sizeof(uint64_t)];
+  struct _QRFlavor_ flavor;
+  int return_value;
+
+  if (options == NULL) options = &QR_DEFAULT_OPTIONS;
+
+  return_value = prepareQRCode(payload, len, options, segments, out, 
+    &flavor);
+  if (return_value != QR_ENCODE_RETURN_SUCCESSFUL) return return_value;
+
+  return_value = generateBlockErrorCorrection(out, NULL);
+  if (return_value != QR_ENCODE_RETURN_SUCCESSFUL) return return_value;
+
+  return finishQRCode(out, &flavor, options);
+}
+
+//------------------------------------------------------------------------------
+/// Size of the workspace of qrEncodeInWorkspace for a matrix of \p size rows
+/// with \p codewords codewords and \p ec_length error correction codewords
+/// per block: the work planes of mkQRMatrix, the interleaved codewords and 
+/// the workspace of the error correction of one block, each padded to 8 
+/// bytes. The segmentation of a payload of up to \p len bytes is done before
+/// and reuses the same bytes.
+//
+#define QR_ENCODING_WORKSPACE_SIZE(size, codewords, ec_length) \
+  (QR_WORK_PLANE_COUNT * (size) * QR_MATRIX_ROW_WORDS * sizeof(uint64_t) + \
+   QR_WORKSPACE_ALIGN(codewords) + \
+   ERROR_CORRECTION_WORKSPACE_SIZE(ec_length))
+#define QR_WORKSPACE_SIZE(len, size, codewords, ec_length) \
+  (QR_ENCODING_WORKSPACE_SIZE(size, codewords, ec_length) > \
+   QR_SEGMENT_WORKSPACE_SIZE(len) ? \
+   QR_ENCODING_WORKSPACE_SIZE(size, codewords, ec_length) : \
+   QR_SEGMENT_WORKSPACE_SIZE(len))
+
+//------------------------------------------------------------------------------
+/// Size of the workspace of qrEncodeInWorkspace that fits every QR-Code
+//
+#define QR_MAX_WORKSPACE_SIZE \
+  QR_WORKSPACE_SIZE(QR_MAX_INPUT_SIZE, QR_MAX_MATRIX_SIZE, QR_MAX_CODEWORDS, \
+    MAX_QR_BLOCK_ECC_LEN)
+
+//------------------------------------------------------------------------------
+///
+/// @brief Returns the size of the workspace qrEncodeInWorkspace needs for the
+/// QR-Codes of \p version, at most QR_MAX_WORKSPACE_SIZE
+/// 
+/// @param version The largest version to encode, 1 to 40
+///
+/// @return The workspace size in bytes, 0 for invalid versions
+//
+static inline size_t qrWorkspaceSize(uint8_t version)
+{
+  const uint8_t flavors_per_version = NUMBER_OF_QR_FLAVORS / MAX_QR_VERSION;
+  uint16_t data_codewords = 0;
+  uint8_t ec_length = 0;
+
+  if (version < MIN_QR_VERSION || version > MAX_QR_VERSION) return 0;
+
+  // the higher error correction levels have more codewords per block, the 
+  // lower ones more data codewords
+  for (uint8_t flavor = 0; flavor < flavors_per_version; flavor++)
+  {
+    const struct _QRFlavor_ *level = 
+      &(QRFlavors[(version - 1) * flavors_per_version + flavor]);
+    if (level->ec_data_ > ec_length) ec_length = level->ec_data_;
+    if (level->data_codewords_ > data_codewords) 
+    {
+      data_codewords = level->data_codewords_;
+    }
+  }
+
+  // the longest payloads are digits, 3 in 10 bits and 1 or 2 in 4 or 7 bits
+  const uint32_t bits = data_codewords * 8 - MODE_INDICATOR_LENGTH - 
+    COUNT_LENGTHS[SEGMENT_NUMERIC][getCountGroup(version)];
+  const uint16_t digits = bits / 10 * 3 + 
+    (bits % 10 >= 7 ? 2 : bits % 10 >= 4 ? 1 : 0);
+
+  return QR_WORKSPACE_SIZE(digits, 21 + 4 * (version - 1), 
+    getVersionCodewords(version), ec_length);
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Encodes \p payload like qrEncode, all working buffers are carved 
+/// out of \p workspace. No memory is allocated and the stack usage is small,
+/// the data modules are placed by walking the zigzag path, the mask patterns
+/// are computed and the error correction codewords are created block by 
+/// block. The time depends on the QR-flavor and on the characters of the 
+/// payload, the segments are searched once per count group until one fits.
+/// 
+/// @param payload The message to encode, it does not need to be terminated
+/// @param len The message length in bytes
+/// @param options The options to use, NULL for the defaults
+/// @param workspace The workspace, aligned to 8 bytes
+/// @param workspace_size The size of \p workspace, see qrWorkspaceSize
+/// @param[out] out The encoded QR-Code
+///
+/// @return see qrEncode, QR_ENCODE_ERROR_OUT_OF_MEMORY if the workspace is 
+///         too small for \p payload or its QR-flavor
+//
+static inline int qrEncodeInWorkspace(const unsigned char *payload, 
+size_t len, const struct _QROptions_ *options, void *workspace, 
+size_t workspace_size, struct _QRCode_ *out)
+{
+  struct _QRFlavor_ flavor;
+  int return_value;
+
+  if (options == NULL) options = &QR_DEFAULT_OPTIONS;
+  if (workspace == NULL || (uintptr_t)workspace % sizeof(uint64_t) != 0) 
+  {
+    return QR_ENCODE_ERROR_INVALID_PARAMETER;
+  }
+  if (len <= QR_MAX_INPUT_SIZE && 
+    workspace_size < QR_SEGMENT_WORKSPACE_SIZE(len)) 
+  {
+    return QR_ENCODE_ERROR_OUT_OF_MEMORY;
+  }
+
+  return_value = prepareQRCode(payload, len, options, workspace, out, 
+    &flavor);
+  if (return_value != QR_ENCODE_RETURN_SUCCESSFUL) return return_value;
+
+  const uint8_t size = 21 + 4 * (flavor.version_ - 1);
+  const uint16_t codeword_count = out->data_codewords_ + out->ec_codewords_;
+  if (workspace_size < QR_ENCODING_WORKSPACE_SIZE(size, codeword_count, 
+    flavor.ec_data_))
+  {
+    return QR_ENCODE_ERROR_OUT_OF_MEMORY;
+  }
+
+  uint64_t (*rows)[QR_MATRIX_ROW_WORDS] = workspace;
+  uint8_t *codewords = (uint8_t *)(rows + QR_WORK_PLANE_COUNT * size);
+  uint8_t *ecc_workspace = codewords + QR_WORKSPACE_ALIGN(codeword_count);
+
+  return_value = generateBlockErrorCorrection(out, ecc_workspace);
+  if (return_value != QR_ENCODE_RETURN_SUCCESSFUL) return return_value;
+
+  return mkQRMatrix(out, &flavor, options, rows, codewords, false);
+}
+
+//------------------------------------------------------------------------------
+/// Max number of payloads qrEncodeBatch encodes in one call
+//
+#define QR_MAX_BATCH_CODES MAX_ECC_BATCH_SIZE
+
+//------------------------------------------------------------------------------
+///
+/// @brief Encodes up to QR_MAX_BATCH_CODES payloads like qrEncode. The error
+/// correction codewords of the same block of all payloads with the same 
+/// QR-flavor are generated together by generateErrorCorrectionCodewordsBatch.
+/// 
+/// @param payloads The messages to encode
+/// @param lengths The message lengths in bytes
+/// @param count The number of messages
+/// @param options The options to use for all messages, NULL for the defaults
+/// @param[out] codes The encoded QR-Codes, one per message
+/// @param[out] return_values The result of every message, see qrEncode
+///
+/// @return QR_ENCODE_RETURN_SUCCESSFUL if the messages were encoded, the 
+///         results of the single messages are in \p return_values, and
+///         QR_ENCODE_ERROR_INVALID_PARAMETER if this function is called with
+///         invalid parameters
+//
+static inline int qrEncodeBatch(const unsigned char *const *payloads, 
+const size_t *lengths, size_t count, const struct _QROptions_ *options, 
+struct _QRCode_ *codes, int *return_values)
+{
+  uint64_t segments[QR_SEGMENT_WORKSPACE_SIZE(QR_MAX_INPUT_SIZE) / 
+    sizeof(uint64_t)];
+  struct _QRFlavor_ flavors[QR_MAX_BATCH_CODES];
+  bool pending[QR_MAX_BATCH_CODES];
+  size_t lanes[QR_MAX_BATCH_CODES];
+  uint8_t messages[QR_MAX_BLOCK_DATA_CODEWORDS * QR_MAX_BATCH_CODES];
+  uint8_t ec_data[MAX_QR_BLOCK_ECC_LEN * QR_MAX_BATCH_CODES];
+  int return_value;
+
+  if ((count > 0 && (payloads == NULL || lengths == NULL || codes == NULL || 
+      return_values == NULL)) || count > QR_MAX_BATCH_CODES)
+  {
+    return QR_ENCODE_ERROR_INVALID_PARAMETER;
+  }
+  if (options == NULL) options = &QR_DEFAULT_OPTIONS;
+
+  for (size_t index = 0; index < count; index++)
+  {
+    return_values[index] = prepareQRCode(payloads[index], lengths[index], 
+      options, segments, &(codes[index]), &(flavors[index]));
+    pending[index] = return_values[index] == QR_ENCODE_RETURN_SUCCESSFUL;
+  }
+
+  // error correction, one pass per QR-flavor and block
+  for (size_t index = 0; index < count; index++)
+  {
+    const struct _QRCode_ *first = &(codes[index]);
+    size_t lane_count = 0;
+
+    // the rejected payloads have no blocks
+    if (!pending[index]) continue;
+    for (size_t other = index; other < count; other++)
+    {
+      if (pending[other] && codes[other].version_ == first->version_ && 
+          codes[other].ec_level_ == first->ec_level_)
+      {
+        pending[other] = false;
+        lanes[lane_count++] = other;
+      }
+    }
+
+    if (lane_count == 1)
+    {
+      return_values[index] = generateBlockErrorCorrection(&(codes[index]), 
+        NULL);
+      continue;
+    }
+
+    const uint16_t ec_length = first->ec_codewords_ / first->blocks_;
+    return_value = QR_ENCODE_RETURN_SUCCESSFUL;
+    for (uint8_t block = 0; block < first->blocks_ && 
+      return_value == QR_ENCODE_RETURN_SUCCESSFUL; block++)
+    {
+      uint16_t length;
+      const uint16_t offset = getDataBlock(first, block, &length);
+
+      // the blocks are interleaved, codeword i of lane l is at i * lanes + l
+      for (size_t lane = 0; lane < lane_count; lane++)
+      {
+        const uint8_t *codewords = codes[lanes[lane]].codewords_ + offset;
+        for (uint16_t codeword = 0; codeword < length; codeword++)
+        {
+          messages[codeword * lane_count + lane] = codewords[codeword];
+        }
+      }
+
+      return_value = convertECCReturnValue(
+        generateErrorCorrectionCodewordsBatch(ec_data, ec_length, messages, 
+        length, lane_count));
+
+      for (size_t lane = 0; lane < lane_count; lane++)
+      {
+        uint8_t *codewords = codes[lanes[lane]].codewords_ + 
+          first->data_codewords_ + block * ec_length;
+        for (uint16_t codeword = 0; codeword < ec_length; codeword++)
+        {
+          codewords[codeword] = ec_data[codeword * lane_count + lane];
+        }
+      }
+    }
+
+    for (size_t lane = 0; lane < lane_count; lane++)
+    {
+      return_values[lanes[lane]] = return_value;
+    }
+  }
+
+  for (size_t index = 0; index < count; index++)
+  {
+    if (return_values[index] != QR_ENCODE_RETURN_SUCCESSFUL) continue;
+    return_values[index] = finishQRCode(&(codes[index]), &(flavors[index]), 
+      options);
+  }
+
+  return QR_ENCODE_RETURN_SUCCESSFUL;
+}
+
+//------------------------------------------------------------------------------
+///
+/// Payloads of one length that share a prefix, e.g. serial numbers. The error
+/// correction codewords of the prefix and of every suffix position are
+/// precomputed per block, see _ECCTemplate_.
+//
+struct _QRTemplate_
+{
+  struct _QROptions_ options_;
+  size_t prefix_length_;
+  size_t length_;
+  // the prefix followed by zeros
+  unsigned char payload_[QR_MAX_BYTE_INPUT_SIZE];
+  // the number of created block templates
+  uint8_t blocks_;
+  struct _ECCTemplate_ ecc_[QR_MAX_BLOCKS];
+};
+
+//------------------------------------------------------------------------------
+///
+/// @brief Frees a template created by qrCreateTemplate
+/// 
+/// @param qr_template The template
+//
+static inline void qrFreeTemplate(struct _QRTemplate_ *qr_template)
+{
+  if (qr_template == NULL) return;
+  for (uint8_t block = 0; block < qr_template->blocks_; block++)
+  {
+    freeECCTemplate(&(qr_template->ecc_[block]));
+  }
+  qr_template->blocks_ = 0;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Creates a template for payloads of \p len bytes starting with 
+/// \p prefix, see qrEncodeFromTemplate. The template must be freed with 
+/// qrFreeTemplate. The payloads are encoded as a single byte mode segment, so
+/// every suffix byte keeps its codewords.
+/// 
+/// @param[out] qr_template The template
+/// @param prefix The fixed start of the payloads
+/// @param prefix_len The prefix length in bytes
+/// @param len The payload length in bytes, including the prefix
+/// @param options The options to use, NULL for the defaults
+///
+/// @return see qrEncode
+//
+static inline int qrCreateTemplate(struct _QRTemplate_ *qr_template, 
+const unsigned char *prefix, size_t prefix_len, size_t len, 
+const struct _QROptions_ *options)
+{
+  struct _QRCode_ code;
+  struct _QRFlavor_ flavor;
+  uint16_t ec_length, offset, length;
+  size_t variable_begin, variable_end, first, last;
+  int return_value;
+
+  if (qr_template == NULL || (prefix == NULL && prefix_len > 0) || 
+      prefix_len > len)
+  {
+    return QR_ENCODE_ERROR_INVALID_PARAMETER;
+  }
+  if (len > QR_MAX_BYTE_INPUT_SIZE) return QR_ENCODE_ERROR_DATA_TOO_LONG;
+  if (options == NULL) options = &QR_DEFAULT_OPTIONS;
+
+  qr_template->options_ = *options;
+  qr_template->prefix_length_ = prefix_len;
+  qr_template->length_ = len;
+  qr_template->blocks_ = 0;
+  memset(qr_template->payload_, 0, sizeof(qr_template->payload_));
+  if (prefix_len > 0) memcpy(qr_template->payload_, prefix, prefix_len);
+
+  return_value = prepareQRCode(qr_template->payload_, len, options, NULL, 
+    &code, &flavor);
+  if (return_value != QR_ENCODE_RETURN_SUCCESSFUL) return return_value;
+
+  // payload byte i is split over the codewords offset + i and offset + i + 1
+  // behind the mode and the character count
+  variable_begin = (flavor.version_ < MIN_LONG_COUNT_VERSION ? 1 : 2) + 
+    prefix_len;
+  variable_end = variable_begin + len - prefix_len + 1;
+  ec_length = code.ec_codewords_ / code.blocks_;
+
+  for (uint8_t block = 0; block < code.blocks_; block++)
+  {
+    offset = getDataBlock(&code, block, &length);
+    first = variable_begin > offset ? variable_begin : offset;
+    last = variable_end < offset + length ? variable_end : offset + length;
+    if (first > last) first = last = offset;
+
+    return_value = createECCTemplate(&(qr_template->ecc_[block]), ec_length, 
+      code.codewords_ + offset, length, first - offset, last - first);
+    if (return_value != ERROR_CORRECTION_RETURN_SUCCESSFUL)
+    {
+      qrFreeTemplate(qr_template);
+      return convertECCReturnValue(return_value);
+    }
+    qr_template->blocks_++;
+  }
+  return QR_ENCODE_RETURN_SUCCESSFUL;
+}
+
+//------------------------------------------------------------------------------
+///
+/// @brief Encodes the prefix of \p qr_template followed by \p suffix like 
+/// qrEncode. The error correction codewords are the ones of the template 
+/// plus the contribution of every changed codeword.
+/// 
+/// @param qr_template The template, see qrCreateTemplate
+/// @param suffix The end of the payload, its length is the template length 
+/// minus the prefix length
+/// @param[out] out The encoded QR-Code
+///
+/// @return see qrEncode
+//
+static inline int qrEncodeFromTemplate(const struct _QRTemplate_ *qr_template, 
+const unsigned char *suffix, struct _QRCode_ *out)
+{
+  unsigned char payload[QR_MAX_BYTE_INPUT_SIZE];
+  struct _QRFlavor_ flavor;
+  uint16_t ec_length, offset, length;
+  int return_value;
+  size_t suffix_len;
+
+  if (qr_template == NULL) return QR_ENCODE_ERROR_INVALID_PARAMETER;
+  suffix_len = qr_template->length_ - qr_template->prefix_length_;
+  if (suffix == NULL && suffix_len > 0) 
+  {
+    return QR_ENCODE_ERROR_INVALID_PARAMETER;
+  }
+
+  memcpy(payload, qr_template->payload_, qr_template->prefix_length_);
+  if (suffix_len > 0)
+  {
+    memcpy(payload + qr_template->prefix_length_, suffix, suffix_len);
+  }
+
+  return_value = prepareQRCode(payload, qr_template->length_, 
+    &(qr_template->options_), NULL, out, &flavor);
+  if (return_value != QR_ENCODE_RETURN_SUCCESSFUL) return return_value;
+
+  ec_length = out->ec_codewords_ / out->blocks_;
+  for (uint8_t block = 0; block < out->blocks_; block++)
+  {
+    offset = getDataBlock(out, block, &length);
+    return_value = generateTemplateErrorCorrectionCodewords(
+      &(qr_template->ecc_[block]), out->codewords_ + out->data_codewords_ + 
+      block * ec_length, out->codewords_ + offset);
+    if (return_value != ERROR_CORRECTION_RETURN_SUCCESSFUL) 
+    {
+      return convertECCReturnValue(return_value);
+    }
+  }
+
+  return finishQRCode(out, &flavor, &(qr_template->options_));
+}
+
+#endif //QRC_ENCODE_H